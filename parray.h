@@ -15,6 +15,10 @@ parray supports the following three configurations:
     Must be defined in exactly one source file within a project for parray to be found by the linker.
 #define PARRAY_STATIC
     Defines all parray functions as static, useful if parray is only used in a single compilation unit.
+#define PARRAY_INLINE
+    Can be combined with either of the above, defines parrayLength, parrayGet, parraySet, parrayGetFirst, parrayGetLast, their
+    unchecked variants, the non-growing part of parrayPush, parrayChunkedLength, parrayChunkedGet and parrayChunkedSet, and
+    parrayValueLength and parrayValueGet as static inline in every compilation unit for use in hot loops.
 
 parray supports the following additional options:
 #define PARRAY_ZALLOC(S)
@@ -23,6 +27,41 @@ parray supports the following additional options:
     Overrides the realloc function used by parray with your own. Defaults to the standard realloc.
 #define PARRAY_FREE(P)
     Overrides the free function used by parray with your own. Defaults to the standard free.
+#define PARRAY_MIN_CAPACITY N
+    Sets the capacity (in elements) of the first allocation made when a parray grows from empty. Defaults to 1.
+#define PARRAY_GROWTH_FACTOR F
+    Sets the factor by which the capacity of a parray is multiplied whenever it needs to grow. Defaults to 2.0.
+#define PARRAY_MAX_GROWTH N
+    Caps the number of elements added to the capacity of a parray by a single growth step. Defaults to 0 (unlimited).
+#define PARRAY_SORT_CUTOFF N
+    Sets the partition size below which sorts switch from quicksort to insertion sort. Defaults to 16.
+#define PARRAY_CHUNK_BITS N
+    Sets the log2 of the number of elements per chunk of a struct parray_chunked. Defaults to 10 (1024 elements, 8 KiB).
+    Since this is used by inline functions, it must be defined identically everywhere parray.h is included.
+#define PARRAY_BATCH N
+    Sets the number of searches parrayFindIndexBatch interleaves. Defaults to 8.
+#define PARRAY_PREFETCH_DISTANCE N
+    Sets how many elements ahead parrayForEach and parrayForEachRange prefetch the memory elements point to. Defaults to 8.
+#define PARRAY_PARALLEL_MIN N
+    Sets the number of elements below which functions taking an executor fall back to running sequentially. Defaults to 65536.
+#define PARRAY_NO_SIMD
+    Disables the SSE2/AVX2/NEON paths of linear scans such as parrayIndexOf, which are otherwise picked at compile time
+    based on the target (AVX2 needs e.g. -mavx2 or /arch:AVX2) whenever pointers are 64 bits wide.
+#define PARRAY_MMAP
+    Provides parrayMmapAlloc, an allocator function for struct parray_allocator that backs large blocks with reserved virtual
+    memory (see parray usage). Requires a POSIX system with anonymous mmap, huge pages are only available on Linux.
+#define PARRAY_QUEUE
+    Provides struct parray_queue, a lock-free concurrent queue (see parray usage). Requires C11 atomics in the implementation.
+#define PARRAY_THREADS
+    Provides parrayRunThreads, a run function for struct parray_executor that uses POSIX threads. Requires linking pthreads.
+#define PARRAY_LARGE
+    Makes lengths, capacities and indices (the PARRAY_INT type used throughout the interface) ptrdiff_t instead of int, so that a
+    parray can hold more than INT_MAX elements on 64-bit targets. Since this changes the layout of struct parray and the
+    signatures of most functions, it must be defined identically everywhere parray.h is included.
+#define PARRAY_SMALL N
+    Embeds storage for N elements directly in each parray instance, so that parrays which never grow beyond N elements don't
+    need a separate buffer allocation. Larger parrays spill over to the heap and move back once shrunk. Defaults to 0 (off).
+    Since this changes the layout of struct parray, it must be defined identically everywhere parray.h is included.
 
 parray usage:
     A parray is a dynamic array of void pointers with a multi-purpose interface, thus allowing it to act as just a dynamic array,
@@ -31,9 +70,85 @@ parray usage:
     If pointers of only one type are stored in a given parray and type-checking is desired, PARRAY_TYPED(TYPE, NAME, FUNC) can be
     used to define a typed parray containing TYPE pointers (e.g. pointers to struct foo), named struct NAME (e.g. struct foo_parray)
     providing all the usual parray functions but prefixed with FUNC instead of parray (e.g. fooDequeue instead of parrayDequeue).
+    Besides being created through parrayNew, a parray may also be embedded in other structs or placed on the stack, in which case
+    it must be set up with parrayInit before use and cleaned up with parrayDeinit afterwards instead of using parrayFree.
+    PARRAY_SORT(TYPE, NAME, LESS) can be used to define a static function void NAME(struct parray*) that sorts a parray containing
+    TYPE pointers smallest to greatest, where LESS(A, B) is a function or macro taking two TYPE pointers that returns non-zero if
+    A is smaller than B. Since LESS is known at compile time it can be inlined, making such a sort much faster than passing a
+    comparison function pointer to parraySortStandard. A typed parray can be sorted by passing (struct parray*)parr to it.
+    Functions taking a struct parray_executor split their work into tasks and hand those to its run function, which may execute
+    them on a thread pool, on threads provided by the caller, or, with PARRAY_THREADS, on threads created by parrayRunThreads.
+    Since parrayRunThreads hands out tasks one at a time as threads become idle, PARRAY_PARALLEL_DYNAMIC balances skewed work
+    in parrayParallelForEach and parrayParallelReduce well there, and run functions of other thread pools should do the same.
+    For sorted parrays that are searched far more often than they are modified, parrayLookupNew can build a separate read-only
+    struct parray_lookup from their integer keys, storing them in a cache-friendly (Eytzinger) layout that is searched without
+    unpredictable branches. It does not track later changes to the parray, so it has to be rebuilt after any modification.
+    Since parrays themselves aren't thread-safe, PARRAY_QUEUE provides struct parray_queue, a separate lock-free queue of void
+    pointers with a parray-like push/dequeue/length interface that may be used from any number of threads at once. It is a ring
+    of fixed capacity with atomic head and tail positions on separate cache lines, optimized for a single producer and
+    consumer with PARRAY_QUEUE_SPSC, and allowed to grow by chaining larger rings with PARRAY_QUEUE_GROW. PARRAY_QUEUE_TYPED(TYPE,
+    NAME, FUNC) defines a typed struct NAME for it with functions prefixed by FUNC the same way PARRAY_TYPED does for parrays.
+    Where reallocating and copying a large buffer is a problem, struct parray_chunked stores elements in fixed-size chunks of
+    PARRAY_CHUNK_BITS elements found through a directory instead, so growing only ever adds chunks and elements never move in
+    memory unless inserted or removed before (parrayChunkedAddress returns such a stable address). All but the first and last
+    chunks are kept full, so indexing stays O(1) through a shift and a mask. Each chunk is a small ring with its own head,
+    so parrayChunkedInsert and parrayChunkedRemove only shift elements within one chunk and carry a single element across
+    each following chunk by moving its head, O(chunk+n/chunk).
+    PARRAY_CHUNKED_TYPED(TYPE, NAME, FUNC) defines a typed struct NAME whose functions have the same names as those defined by
+    PARRAY_TYPED, so that code using only their common subset can switch between the two by changing the generator.
+    For small plain records that would otherwise need one allocation per element, struct parray_value stores the elements
+    themselves instead of pointers to them, all of the same size given on creation, contiguously in one buffer. Its functions
+    copy elements in and out through pointers with memcpy, and getters return the address of an element within the buffer,
+    valid until the next modifying call. PARRAY_VALUE_TYPED(TYPE, NAME, FUNC) defines a typed struct NAME for TYPE elements
+    (which must be a complete type) whose functions take and copy TYPE values, with the usual names where their meaning fits.
+    From C++ (11 or later), pa::array<T*> is a class template over struct parray holding T pointers, which owns its parray like
+    parrayInit/parrayDeinit would, transfers it on move instead of copying, provides begin/end over raw element pointers, and
+    has sort and find members taking lambdas that are inlined at compile time. It has the same layout as struct parray, so
+    raw() and wrap() pass instances between C and C++ code. The implementation itself must be compiled as C, so C++ code
+    includes parray.h without PARRAY_IMPLEMENTATION or PARRAY_STATIC, ideally with PARRAY_INLINE for the accessors.
+    parrayClone makes an independent copy of a parray with its elements in order and exactly as much room as they need, while
+    parraySnapshot makes one that shares the buffer of the original in O(1), e.g. to hand a consistent view of it to a reader
+    on another thread while the writer carries on. Whichever of the two is modified first copies the buffer before doing so,
+    the reference count deciding who does and who frees the buffer in the end is atomic where the compiler supports it.
+    To avoid rebuilding e.g. large sorted parrays at startup, parraySerialize writes an image of a parray, a 32 byte header
+    followed by its elements in order as native pointer-sized offsets from a given base (or as plain pointer values without
+    one), into a buffer that may then be written to a file. parrayLoad fills a parray from such an image, adding a base back
+    to the offsets in one pass without sorting anything again. parrayMapImage instead sets up a read-only parray on top of an
+    image in memory without copying it, whose elements are the stored values themselves, so comparison functions have to add
+    the base themselves unless the image was written without one. With PARRAY_MMAP, parrayMapFile does the same for a file
+    mapped into memory, which is unmapped once the parray is cleaned up. Modifying such a parray copies the elements first.
+    Parrays created with parrayNewEx or set up with parrayInitEx use the given struct parray_allocator for all their memory instead
+    of the PARRAY_ZALLOC/REALLOC/FREE macros, allowing e.g. per-thread pools or arenas that release many parrays at once.
+    With PARRAY_MMAP, using parrayMmapAlloc as that allocator (with a struct parray_mmap as its user pointer) makes every block of
+    at least threshold bytes reserve a large range of address space up front and commit pages within it as the block grows, so
+    huge parrays grow and shrink in place without copying. PARRAY_MMAP_HUGE asks for transparent huge pages on those ranges,
+    while PARRAY_MMAP_HUGETLB uses explicit huge pages if the system has any configured, both of which reduce TLB misses.
+
+parray modes:
+    Optional behaviour can be enabled per instance by passing a combination of the following flags to parrayMode:
+    PARRAY_RING
+        Turns the parray into a circular buffer whose head and tail wrap around its capacity, so that parrayPush, parrayPushFront
+        and parrayDequeue are strictly O(1) and never compact. Functions that require contiguous storage (sorting,
+        inserting, removing, bulk operations, resizing) unwrap the elements first, which is O(n) but only when wrapped.
+    PARRAY_SHRINK
+        Makes functions that remove elements halve the capacity of the parray once its length drops below a quarter of its
+        capacity (never below PARRAY_MIN_CAPACITY), reclaiming space left behind by dequeues in the process. The gap between
+        the growth and shrink thresholds avoids repeated reallocation when the length hovers around either of them.
+    PARRAY_INDEX
+        Maintains a hash table mapping each element to its index alongside the parray, so that parrayIndexOf and parrayContains
+        become O(1) on average. Every modifying function keeps it up to date, at the cost of extra memory and some overhead,
+        and those that shift or reorder elements (inserting, removing, sorting) rebuild it in O(n). Unlike the other modes,
+        elements must not be modified through parrayData. Should memory for the table run out, the mode is silently disabled.
+    PARRAY_GAP
+        Turns the parray into a gap buffer for clustered edits, keeping its free space at the index of the last parrayInsert or
+        parrayRemove, so that further edits there are amortized O(1) and moving to another index only costs the distance moved.
+        Storage is a ring whose start is rotated to that index, so indexed access keeps working across the gap in O(1) and
+        growth never copies more than once. Functions that need elements in order (anything parrayData would be needed for,
+        pushing, popping, dequeuing, scans by predicate) close the gap first, which is O(n) at worst.
 
 parray performance:
     Where relevant, parray functions perform bounds checking, which may incur a small (but likely negligible) performance overhead.
+    Where it isn't negligible, parrayGetUnchecked/parraySetUnchecked skip it, and parrayData exposes the elements as a plain array.
     The different usage patterns supported by parray (stack, queue, regular array, etc...) are balanced in such a way that each of
     them performs as close to optimally as possible without slowing down the others, minimizing the performance cost of versatility.
 
@@ -46,6 +161,11 @@ parray returns:
 #ifndef PARRAY_H
 #define PARRAY_H
 
+//includes
+#include <stddef.h> //size_t
+#include <stdint.h> //uint64_t
+#include <limits.h> //INT_MAX
+
 //process configuration
 #ifdef PARRAY_STATIC
     #define PARRAY_IMPLEMENTATION
@@ -53,23 +173,88 @@ parray returns:
 #else //PARRAY_EXTERN
     #define PADEF extern
 #endif
+#ifdef PARRAY_INLINE
+    #define PAINL static inline
+#else
+    #define PAINL PADEF
+#endif
+#ifdef PARRAY_LARGE
+    #define PARRAY_INT ptrdiff_t
+    #define PARRAY_INT_MAX PTRDIFF_MAX
+#else
+    #define PARRAY_INT int
+    #define PARRAY_INT_MAX INT_MAX
+#endif
+#ifndef PARRAY_SMALL
+    #define PARRAY_SMALL 0
+#endif
+#ifndef PARRAY_CHUNK_BITS
+    #define PARRAY_CHUNK_BITS 10
+#endif
+#ifndef PARRAY_SORT_CUTOFF
+    #define PARRAY_SORT_CUTOFF 16
+#endif
+
+//constants
+#define PARRAY_RING 1 //circular buffer mode, see parrayMode
+#define PARRAY_SHRINK 2 //automatic shrinking mode, see parrayMode
+#define PARRAY_INDEX 4 //hash index mode, see parrayMode
+#define PARRAY_GAP 8 //gap buffer mode, see parrayMode
+#define PARRAY_QUEUE_SPSC 1 //single producer single consumer queue, see parrayQueueNew
+#define PARRAY_QUEUE_GROW 2 //growable queue, see parrayQueueNew
+#define PARRAY_MMAP_HUGE 1 //transparent huge pages, see struct parray_mmap
+#define PARRAY_MMAP_HUGETLB 2 //explicit huge pages, see struct parray_mmap
+#define PARRAY_PARALLEL_DYNAMIC 1 //many small chunks claimed by idle threads, see parrayParallelForEach
 
 //macros
 #define PARRAY_TYPED(TYPE, NAME, FUNC) \
-    TYPE; struct NAME; \
+    TYPE; struct NAME {struct parray parr;}; \
+    static void FUNC##Init (struct NAME* parr) { \
+        parrayInit((struct parray*)parr); \
+    } \
+    static void FUNC##Deinit (struct NAME* parr) { \
+        parrayDeinit((struct parray*)parr); \
+    } \
+    static void FUNC##InitEx (struct NAME* parr, const struct parray_allocator* alloc) { \
+        parrayInitEx((struct parray*)parr, alloc); \
+    } \
+    static struct NAME* FUNC##NewEx (const struct parray_allocator* alloc) { \
+        return (struct NAME*)parrayNewEx(alloc); \
+    } \
     static struct NAME* FUNC##New () { \
         return (struct NAME*)parrayNew(); \
     } \
-    static int FUNC##Length (const struct NAME* parr) { \
+    static struct NAME* FUNC##NewWithCapacity (PARRAY_INT cap) { \
+        return (struct NAME*)parrayNewWithCapacity(cap); \
+    } \
+    static struct NAME* FUNC##Clone (const struct NAME* parr) { \
+        return (struct NAME*)parrayClone((const struct parray*)parr); \
+    } \
+    static struct NAME* FUNC##Snapshot (struct NAME* parr) { \
+        return (struct NAME*)parraySnapshot((struct parray*)parr); \
+    } \
+    static size_t FUNC##Serialize (const struct NAME* parr, const void* base, void* buf, size_t size) { \
+        return parraySerialize((const struct parray*)parr, base, buf, size); \
+    } \
+    static int FUNC##Load (struct NAME* parr, const void* image, size_t size, const void* base) { \
+        return parrayLoad((struct parray*)parr, image, size, base); \
+    } \
+    static int FUNC##MapImage (struct NAME* parr, const void* image, size_t size) { \
+        return parrayMapImage((struct parray*)parr, image, size); \
+    } \
+    static PARRAY_INT FUNC##Length (const struct NAME* parr) { \
         return parrayLength((const struct parray*)parr); \
     } \
-    static int FUNC##Set (struct NAME* parr, int ind, TYPE* ele) { \
+    static PARRAY_INT FUNC##Set (struct NAME* parr, PARRAY_INT ind, TYPE* ele) { \
         return parraySet((struct parray*)parr, ind, (void*)ele); \
     } \
-    static int FUNC##IndexOf (const struct NAME* parr, TYPE* ele) { \
+    static PARRAY_INT FUNC##IndexOf (const struct NAME* parr, TYPE* ele) { \
         return parrayIndexOf((const struct parray*)parr, (void*)ele); \
     } \
-    static TYPE* FUNC##Get (const struct NAME* parr, int ind) { \
+    static int FUNC##Contains (const struct NAME* parr, TYPE* ele) { \
+        return parrayContains((const struct parray*)parr, (void*)ele); \
+    } \
+    static TYPE* FUNC##Get (const struct NAME* parr, PARRAY_INT ind) { \
         return (TYPE*)parrayGet((const struct parray*)parr, ind); \
     } \
     static TYPE* FUNC##GetFirst (const struct NAME* parr) { \
@@ -78,13 +263,25 @@ parray returns:
     static TYPE* FUNC##GetLast (const struct NAME* parr) { \
         return (TYPE*)parrayGetLast((const struct parray*)parr); \
     } \
+    static TYPE* FUNC##GetUnchecked (const struct NAME* parr, PARRAY_INT ind) { \
+        return (TYPE*)parrayGetUnchecked((const struct parray*)parr, ind); \
+    } \
+    static void FUNC##SetUnchecked (struct NAME* parr, PARRAY_INT ind, TYPE* ele) { \
+        parraySetUnchecked((struct parray*)parr, ind, (void*)ele); \
+    } \
+    static TYPE** FUNC##Data (struct NAME* parr) { \
+        return (TYPE**)parrayData((struct parray*)parr); \
+    } \
+    static void FUNC##Reindex (struct NAME* parr) { \
+        parrayReindex((struct parray*)parr); \
+    } \
     static void FUNC##Clear (struct NAME* parr) { \
         parrayClear((struct parray*)parr); \
     } \
     static void FUNC##Free (struct NAME* parr) { \
         parrayFree((struct parray*)parr); \
     } \
-    static int FUNC##Push (struct NAME* parr, TYPE* ele) { \
+    static PARRAY_INT FUNC##Push (struct NAME* parr, TYPE* ele) { \
         return parrayPush((struct parray*)parr, (void*)ele); \
     } \
     static TYPE* FUNC##Pop (struct NAME* parr) { \
@@ -93,87 +290,894 @@ parray returns:
     static TYPE* FUNC##Dequeue (struct NAME* parr) { \
         return (TYPE*)parrayDequeue((struct parray*)parr); \
     } \
-    static int FUNC##FindIndex (const struct NAME* parr, int(*comp)(const void*, const TYPE**), const void* key) { \
+    static PARRAY_INT FUNC##DequeueN (struct NAME* parr, TYPE** out, PARRAY_INT max) { \
+        return parrayDequeueN((struct parray*)parr, (void**)out, max); \
+    } \
+    static TYPE** FUNC##Drain (struct NAME* parr, PARRAY_INT* num) { \
+        return (TYPE**)parrayDrain((struct parray*)parr, num); \
+    } \
+    static PARRAY_INT FUNC##FindIndex (const struct NAME* parr, int(*comp)(const void*, const TYPE**), const void* key) { \
         return parrayFindIndex((const struct parray*)parr, (int(*)(const void*, const void**))comp, key); \
     } \
+    static void FUNC##FindIndexBatch (const struct NAME* parr, int(*comp)(const void*, const TYPE**), const void* const* keys, PARRAY_INT num, PARRAY_INT* out) { \
+        parrayFindIndexBatch((const struct parray*)parr, (int(*)(const void*, const void**))comp, keys, num, out); \
+    } \
     static TYPE* FUNC##FindElement (const struct NAME* parr, int(*comp)(const void*, const TYPE**), const void* key) { \
         return (TYPE*)parrayFindElement((const struct parray*)parr, (int(*)(const void*, const void**))comp, key); \
     } \
+    static PARRAY_INT FUNC##LowerBound (const struct NAME* parr, int(*comp)(const void*, const TYPE**), const void* key) { \
+        return parrayLowerBound((const struct parray*)parr, (int(*)(const void*, const void**))comp, key); \
+    } \
+    static PARRAY_INT FUNC##UpperBound (const struct NAME* parr, int(*comp)(const void*, const TYPE**), const void* key) { \
+        return parrayUpperBound((const struct parray*)parr, (int(*)(const void*, const void**))comp, key); \
+    } \
+    static PARRAY_INT FUNC##SortedInsert (struct NAME* parr, int(*comp)(const TYPE**, const TYPE**), TYPE* ele) { \
+        return parraySortedInsert((struct parray*)parr, (int(*)(const void**, const void**))comp, (void*)ele); \
+    } \
+    static TYPE* FUNC##SortedRemove (struct NAME* parr, int(*comp)(const void*, const TYPE**), const void* key) { \
+        return (TYPE*)parraySortedRemove((struct parray*)parr, (int(*)(const void*, const void**))comp, key); \
+    } \
+    static struct parray_lookup* FUNC##LookupNew (const struct NAME* parr, uint64_t(*key)(const TYPE*)) { \
+        return parrayLookupNew((const struct parray*)parr, (uint64_t(*)(const void*))key); \
+    } \
     static void FUNC##SortInsert (struct NAME* parr, int(*comp)(const TYPE**, const TYPE**)) { \
         parraySortInsert((struct parray*)parr, (int(*)(const void**, const void**))comp); \
     } \
     static void FUNC##SortStandard (struct NAME* parr, int(*comp)(const TYPE**, const TYPE**)) { \
         parraySortStandard((struct parray*)parr, (int(*)(const void**, const void**))comp); \
     } \
-    static int FUNC##Insert (struct NAME* parr, int ind, TYPE* ele) { \
+    static int FUNC##SortParallel (struct NAME* parr, int(*comp)(const TYPE**, const TYPE**), const struct parray_executor* exec) { \
+        return parraySortParallel((struct parray*)parr, (int(*)(const void**, const void**))comp, exec); \
+    } \
+    static int FUNC##SortByKey (struct NAME* parr, uint64_t(*key)(const TYPE*)) { \
+        return parraySortByKey((struct parray*)parr, (uint64_t(*)(const void*))key); \
+    } \
+    static PARRAY_INT FUNC##Insert (struct NAME* parr, PARRAY_INT ind, TYPE* ele) { \
         return parrayInsert((struct parray*)parr, ind, (void*)ele); \
     } \
-    static TYPE* FUNC##Remove (struct NAME* parr, int ind) { \
+    static TYPE* FUNC##Remove (struct NAME* parr, PARRAY_INT ind) { \
         return (TYPE*)parrayRemove((struct parray*)parr, ind); \
     } \
-    static TYPE* FUNC##Ditch (struct NAME* parr, int ind) { \
+    static TYPE* FUNC##Ditch (struct NAME* parr, PARRAY_INT ind) { \
         return (TYPE*)parrayDitch((struct parray*)parr, ind); \
     } \
-    static int FUNC##Capacity (struct NAME* parr, int cap) { \
+    static PARRAY_INT FUNC##RemoveIf (struct NAME* parr, int(*pred)(TYPE*, void*), void* ctx) { \
+        return parrayRemoveIf((struct parray*)parr, (int(*)(void*, void*))pred, ctx); \
+    } \
+    static PARRAY_INT FUNC##DitchIf (struct NAME* parr, int(*pred)(TYPE*, void*), void* ctx) { \
+        return parrayDitchIf((struct parray*)parr, (int(*)(void*, void*))pred, ctx); \
+    } \
+    static PARRAY_INT FUNC##Capacity (struct NAME* parr, PARRAY_INT cap) { \
         return parrayCapacity((struct parray*)parr, cap); \
+    } \
+    static PARRAY_INT FUNC##PushN (struct NAME* parr, TYPE** eles, PARRAY_INT num) { \
+        return parrayPushN((struct parray*)parr, (void**)eles, num); \
+    } \
+    static PARRAY_INT FUNC##InsertN (struct NAME* parr, PARRAY_INT ind, TYPE** eles, PARRAY_INT num) { \
+        return parrayInsertN((struct parray*)parr, ind, (void**)eles, num); \
+    } \
+    static PARRAY_INT FUNC##RemoveRange (struct NAME* parr, PARRAY_INT ind, TYPE** out, PARRAY_INT num) { \
+        return parrayRemoveRange((struct parray*)parr, ind, (void**)out, num); \
+    } \
+    static PARRAY_INT FUNC##PushFront (struct NAME* parr, TYPE* ele) { \
+        return parrayPushFront((struct parray*)parr, (void*)ele); \
+    } \
+    static void FUNC##ForEach (const struct NAME* parr, void(*fn)(TYPE*, void*), void* ctx) { \
+        parrayForEach((const struct parray*)parr, (void(*)(void*, void*))fn, ctx); \
+    } \
+    static PARRAY_INT FUNC##ForEachRange (const struct NAME* parr, PARRAY_INT ind, PARRAY_INT num, void(*fn)(TYPE*, void*), void* ctx) { \
+        return parrayForEachRange((const struct parray*)parr, ind, num, (void(*)(void*, void*))fn, ctx); \
+    } \
+    static int FUNC##ForEachBatch (const struct NAME* parr, PARRAY_INT batch, void(*fn)(TYPE* const*, PARRAY_INT, void*), void* ctx) { \
+        return parrayForEachBatch((const struct parray*)parr, batch, (void(*)(void* const*, PARRAY_INT, void*))fn, ctx); \
+    } \
+    static void FUNC##ParallelForEach (const struct NAME* parr, void(*fn)(TYPE*, void*), void* ctx, const struct parray_executor* exec, int flags) { \
+        parrayParallelForEach((const struct parray*)parr, (void(*)(void*, void*))fn, ctx, exec, flags); \
+    } \
+    static int FUNC##ParallelReduce (const struct NAME* parr, size_t size, void* acc, void(*fold)(void*, TYPE*, void*), void(*combine)(void*, const void*, void*), void* ctx, const struct parray_executor* exec, int flags) { \
+        return parrayParallelReduce((const struct parray*)parr, size, acc, (void(*)(void*, void*, void*))fold, combine, ctx, exec, flags); \
+    } \
+    static int FUNC##Mode (struct NAME* parr, int mode) { \
+        return parrayMode((struct parray*)parr, mode); \
+    } \
+    static size_t FUNC##Released (const struct NAME* parr) { \
+        return parrayReleased((const struct parray*)parr); \
+    }
+
+#define PARRAY_SORT(TYPE, NAME, LESS) \
+    PARRAY_SORT_ENGINE(TYPE, NAME##Engine, LESS, const void*) \
+    static void NAME (struct parray* parr) { \
+        TYPE** data = (TYPE**)parrayData(parr); \
+        if (!data) return; \
+        NAME##Engine(data, parrayLength(parr), NULL); \
+        parrayReindex(parr); \
+    }
+#define PARRAY_SORT_ENGINE(TYPE, NAME, LESS, CTX) \
+    static void NAME (TYPE** data, PARRAY_INT num, CTX ctx) { \
+        /*introsort with an insertion sort fast path for nearly sorted input, LESS may use ctx*/ \
+        struct {PARRAY_INT lo, hi, depth;} stack[64]; \
+        PARRAY_INT top = 0, lo = 0, hi = num-1, depth = 2, moves = num/8+PARRAY_SORT_CUTOFF, i, j; \
+        TYPE* temp; (void)ctx; \
+        /*attempt an insertion sort that gives up once it has moved too many elements*/ \
+        for (i = 1; (i < num)&&(moves >= 0); i++) { \
+            temp = data[i]; \
+            for (j = i; (j > 0)&&(LESS(temp, data[j-1])); j--, moves--) data[j] = data[j-1]; \
+            data[j] = temp; \
+        } \
+        if (moves >= 0) return; \
+        for (i = num; i > 1; i >>= 1) depth += 2; \
+        for (;;) { \
+            while (hi-lo >= PARRAY_SORT_CUTOFF) { \
+                if (!depth--) { \
+                    /*too many bad pivots, heapsort the range instead*/ \
+                    TYPE** base = &data[lo]; PARRAY_INT size = hi-lo+1, start = size/2, root, child; \
+                    for (;;) { \
+                        if (start > 0) root = --start; \
+                        else if (--size > 0) {temp = base[0]; base[0] = base[size]; base[size] = temp; root = 0;} \
+                        else break; \
+                        while ((child = 2*root+1) < size) { \
+                            if ((child+1 < size)&&(LESS(base[child], base[child+1]))) child++; \
+                            if (!LESS(base[root], base[child])) break; \
+                            temp = base[root]; base[root] = base[child]; base[child] = temp; root = child; \
+                        } \
+                    } \
+                    break; \
+                } \
+                /*hoare partition around the median of first, middle, and last element*/ \
+                PARRAY_INT mid = lo+(hi-lo)/2; \
+                if (LESS(data[mid], data[lo])) {temp = data[mid]; data[mid] = data[lo]; data[lo] = temp;} \
+                if (LESS(data[hi], data[mid])) {temp = data[hi]; data[hi] = data[mid]; data[mid] = temp;} \
+                if (LESS(data[mid], data[lo])) {temp = data[mid]; data[mid] = data[lo]; data[lo] = temp;} \
+                TYPE* pivot = data[mid]; i = lo-1; j = hi+1; \
+                for (;;) { \
+                    do i++; while (LESS(data[i], pivot)); \
+                    do j--; while (LESS(pivot, data[j])); \
+                    if (i >= j) break; \
+                    temp = data[i]; data[i] = data[j]; data[j] = temp; \
+                } \
+                /*defer the larger half and continue with the smaller one, keeping the stack shallow*/ \
+                if (j-lo > hi-j) {stack[top].lo = lo; stack[top].hi = j; lo = j+1;} \
+                else {stack[top].lo = j+1; stack[top].hi = hi; hi = j;} \
+                stack[top++].depth = depth; \
+            } \
+            if (!top) break; \
+            top--; lo = stack[top].lo; hi = stack[top].hi; depth = stack[top].depth; \
+        } \
+        /*finish the small partitions left behind by quicksort*/ \
+        for (i = 1; i < num; i++) { \
+            temp = data[i]; \
+            for (j = i; (j > 0)&&(LESS(temp, data[j-1])); j--) data[j] = data[j-1]; \
+            data[j] = temp; \
+        } \
+    }
+
+#define PARRAY_CHUNKED_TYPED(TYPE, NAME, FUNC) \
+    struct NAME {struct parray_chunked arr;}; \
+    static void FUNC##Init (struct NAME* arr) { \
+        parrayChunkedInit((struct parray_chunked*)arr); \
+    } \
+    static void FUNC##Deinit (struct NAME* arr) { \
+        parrayChunkedDeinit((struct parray_chunked*)arr); \
+    } \
+    static void FUNC##InitEx (struct NAME* arr, const struct parray_allocator* alloc) { \
+        parrayChunkedInitEx((struct parray_chunked*)arr, alloc); \
+    } \
+    static struct NAME* FUNC##NewEx (const struct parray_allocator* alloc) { \
+        return (struct NAME*)parrayChunkedNewEx(alloc); \
+    } \
+    static struct NAME* FUNC##New () { \
+        return (struct NAME*)parrayChunkedNew(); \
+    } \
+    static PARRAY_INT FUNC##Length (const struct NAME* arr) { \
+        return parrayChunkedLength((const struct parray_chunked*)arr); \
+    } \
+    static PARRAY_INT FUNC##Set (struct NAME* arr, PARRAY_INT ind, TYPE* ele) { \
+        return parrayChunkedSet((struct parray_chunked*)arr, ind, (void*)ele); \
+    } \
+    static TYPE* FUNC##Get (const struct NAME* arr, PARRAY_INT ind) { \
+        return (TYPE*)parrayChunkedGet((const struct parray_chunked*)arr, ind); \
+    } \
+    static TYPE* FUNC##GetFirst (const struct NAME* arr) { \
+        return (TYPE*)parrayChunkedGetFirst((const struct parray_chunked*)arr); \
+    } \
+    static TYPE* FUNC##GetLast (const struct NAME* arr) { \
+        return (TYPE*)parrayChunkedGetLast((const struct parray_chunked*)arr); \
+    } \
+    static TYPE** FUNC##Address (struct NAME* arr, PARRAY_INT ind) { \
+        return (TYPE**)parrayChunkedAddress((struct parray_chunked*)arr, ind); \
+    } \
+    static PARRAY_INT FUNC##IndexOf (const struct NAME* arr, TYPE* ele) { \
+        return parrayChunkedIndexOf((const struct parray_chunked*)arr, (void*)ele); \
+    } \
+    static int FUNC##Contains (const struct NAME* arr, TYPE* ele) { \
+        return parrayChunkedIndexOf((const struct parray_chunked*)arr, (void*)ele) >= 0; \
+    } \
+    static void FUNC##Clear (struct NAME* arr) { \
+        parrayChunkedClear((struct parray_chunked*)arr); \
+    } \
+    static void FUNC##Free (struct NAME* arr) { \
+        parrayChunkedFree((struct parray_chunked*)arr); \
+    } \
+    static PARRAY_INT FUNC##Push (struct NAME* arr, TYPE* ele) { \
+        return parrayChunkedPush((struct parray_chunked*)arr, (void*)ele); \
+    } \
+    static TYPE* FUNC##Pop (struct NAME* arr) { \
+        return (TYPE*)parrayChunkedPop((struct parray_chunked*)arr); \
+    } \
+    static TYPE* FUNC##Dequeue (struct NAME* arr) { \
+        return (TYPE*)parrayChunkedDequeue((struct parray_chunked*)arr); \
+    } \
+    static PARRAY_INT FUNC##Insert (struct NAME* arr, PARRAY_INT ind, TYPE* ele) { \
+        return parrayChunkedInsert((struct parray_chunked*)arr, ind, (void*)ele); \
+    } \
+    static TYPE* FUNC##Remove (struct NAME* arr, PARRAY_INT ind) { \
+        return (TYPE*)parrayChunkedRemove((struct parray_chunked*)arr, ind); \
+    } \
+    static TYPE* FUNC##Ditch (struct NAME* arr, PARRAY_INT ind) { \
+        return (TYPE*)parrayChunkedDitch((struct parray_chunked*)arr, ind); \
+    } \
+    static PARRAY_INT FUNC##Capacity (struct NAME* arr, PARRAY_INT cap) { \
+        return parrayChunkedCapacity((struct parray_chunked*)arr, cap); \
+    }
+#define PARRAY_VALUE_TYPED(TYPE, NAME, FUNC) \
+    struct NAME {struct parray_value arr;}; \
+    static void FUNC##Init (struct NAME* arr) { \
+        parrayValueInit((struct parray_value*)arr, sizeof(TYPE)); \
+    } \
+    static void FUNC##Deinit (struct NAME* arr) { \
+        parrayValueDeinit((struct parray_value*)arr); \
+    } \
+    static void FUNC##InitEx (struct NAME* arr, const struct parray_allocator* alloc) { \
+        parrayValueInitEx((struct parray_value*)arr, sizeof(TYPE), alloc); \
+    } \
+    static struct NAME* FUNC##NewEx (const struct parray_allocator* alloc) { \
+        return (struct NAME*)parrayValueNewEx(sizeof(TYPE), alloc); \
+    } \
+    static struct NAME* FUNC##New () { \
+        return (struct NAME*)parrayValueNew(sizeof(TYPE)); \
+    } \
+    static PARRAY_INT FUNC##Length (const struct NAME* arr) { \
+        return parrayValueLength((const struct parray_value*)arr); \
+    } \
+    static PARRAY_INT FUNC##Set (struct NAME* arr, PARRAY_INT ind, TYPE ele) { \
+        return parrayValueSet((struct parray_value*)arr, ind, &ele); \
+    } \
+    static TYPE* FUNC##Get (const struct NAME* arr, PARRAY_INT ind) { \
+        return (TYPE*)parrayValueGet((const struct parray_value*)arr, ind); \
+    } \
+    static TYPE* FUNC##GetFirst (const struct NAME* arr) { \
+        return (TYPE*)parrayValueGetFirst((const struct parray_value*)arr); \
+    } \
+    static TYPE* FUNC##GetLast (const struct NAME* arr) { \
+        return (TYPE*)parrayValueGetLast((const struct parray_value*)arr); \
+    } \
+    static TYPE* FUNC##Data (struct NAME* arr) { \
+        return (TYPE*)parrayValueData((struct parray_value*)arr); \
+    } \
+    static void FUNC##Clear (struct NAME* arr) { \
+        parrayValueClear((struct parray_value*)arr); \
+    } \
+    static void FUNC##Free (struct NAME* arr) { \
+        parrayValueFree((struct parray_value*)arr); \
+    } \
+    static PARRAY_INT FUNC##Push (struct NAME* arr, TYPE ele) { \
+        return parrayValuePush((struct parray_value*)arr, &ele); \
+    } \
+    static int FUNC##Pop (struct NAME* arr, TYPE* out) { \
+        return parrayValuePop((struct parray_value*)arr, (void*)out); \
+    } \
+    static int FUNC##Dequeue (struct NAME* arr, TYPE* out) { \
+        return parrayValueDequeue((struct parray_value*)arr, (void*)out); \
+    } \
+    static PARRAY_INT FUNC##Insert (struct NAME* arr, PARRAY_INT ind, TYPE ele) { \
+        return parrayValueInsert((struct parray_value*)arr, ind, &ele); \
+    } \
+    static int FUNC##Remove (struct NAME* arr, PARRAY_INT ind, TYPE* out) { \
+        return parrayValueRemove((struct parray_value*)arr, ind, (void*)out); \
+    } \
+    static int FUNC##Ditch (struct NAME* arr, PARRAY_INT ind, TYPE* out) { \
+        return parrayValueDitch((struct parray_value*)arr, ind, (void*)out); \
+    } \
+    static void FUNC##SortStandard (struct NAME* arr, int(*comp)(const TYPE*, const TYPE*)) { \
+        parrayValueSortStandard((struct parray_value*)arr, (int(*)(const void*, const void*))comp); \
+    } \
+    static PARRAY_INT FUNC##FindIndex (const struct NAME* arr, int(*comp)(const void*, const TYPE*), const void* key) { \
+        return parrayValueFindIndex((const struct parray_value*)arr, (int(*)(const void*, const void*))comp, key); \
+    } \
+    static TYPE* FUNC##FindElement (const struct NAME* arr, int(*comp)(const void*, const TYPE*), const void* key) { \
+        return (TYPE*)parrayValueFindElement((const struct parray_value*)arr, (int(*)(const void*, const void*))comp, key); \
+    } \
+    static PARRAY_INT FUNC##LowerBound (const struct NAME* arr, int(*comp)(const void*, const TYPE*), const void* key) { \
+        return parrayValueLowerBound((const struct parray_value*)arr, (int(*)(const void*, const void*))comp, key); \
+    } \
+    static PARRAY_INT FUNC##Capacity (struct NAME* arr, PARRAY_INT cap) { \
+        return parrayValueCapacity((struct parray_value*)arr, cap); \
+    }
+#define PARRAY_QUEUE_TYPED(TYPE, NAME, FUNC) \
+    struct NAME; \
+    static struct NAME* FUNC##New (PARRAY_INT cap, int flags) { \
+        return (struct NAME*)parrayQueueNew(cap, flags); \
+    } \
+    static struct NAME* FUNC##NewEx (PARRAY_INT cap, int flags, const struct parray_allocator* alloc) { \
+        return (struct NAME*)parrayQueueNewEx(cap, flags, alloc); \
+    } \
+    static int FUNC##Push (struct NAME* queue, TYPE* ele) { \
+        return parrayQueuePush((struct parray_queue*)queue, (void*)ele); \
+    } \
+    static TYPE* FUNC##Dequeue (struct NAME* queue) { \
+        return (TYPE*)parrayQueueDequeue((struct parray_queue*)queue); \
+    } \
+    static PARRAY_INT FUNC##Length (struct NAME* queue) { \
+        return parrayQueueLength((struct parray_queue*)queue); \
+    } \
+    static void FUNC##Free (struct NAME* queue) { \
+        parrayQueueFree((struct parray_queue*)queue); \
     }
 
 //structs
-struct parray; //forward declaration
+#ifdef __cplusplus
+extern "C" {
+#endif
+struct parray_allocator {
+    void* (*alloc)(void* user, void* ptr, size_t oldsize, size_t newsize);
+        //allocates (ptr is NULL), resizes, or frees (newsize is 0, must return NULL) memory like realloc does
+        //oldsize is the size ptr was last allocated or resized with (0 if ptr is NULL), user is passed through as is
+    void* user; //context pointer passed to alloc
+};
+struct parray_executor {
+    void (*run)(const struct parray_executor* exec, void (*task)(void* ctx, int ind), void* ctx, int num);
+        //calls task(ctx, ind) for every ind from 0 to num-1, possibly in parallel, returning once all calls have finished
+    void* user; //context pointer for use by run
+    int threads; //number of tasks run can execute at the same time
+};
+struct parray_mmap {
+    //configuration for parrayMmapAlloc, e.g. {1 << 20, (size_t)1 << 36, PARRAY_MMAP_HUGE} for 64 GiB ranges past 1 MiB
+    size_t threshold; //blocks of at least this many bytes are mapped, smaller ones use the PARRAY_* macros
+    size_t reserve; //bytes of address space reserved per mapped block, growing beyond that means moving to a bigger range
+    int flags; //combination of PARRAY_MMAP_* flags
+};
+struct parray_chunk {
+    //directory entry of struct parray_chunked, all members are internal
+    void** data; //ring of PARRAY_CHUNK_BITS elements
+    PARRAY_INT head; //slot in data holding the first element of the chunk
+};
+struct parray_chunked {
+    //all members are internal, the struct is only public so it can be embedded, use the parrayChunked functions instead
+    PARRAY_INT offset; //index of the first element within the first chunk
+    PARRAY_INT length; //number of elements
+    PARRAY_INT chunks; //number of allocated chunks, including unused ones past the last element
+    PARRAY_INT slots; //number of chunks dir has room for
+    const struct parray_allocator* alloc; //allocator used for all memory, NULL to use the PARRAY_* macros
+    struct parray_chunk* dir; //chunk directory
+};
+struct parray_value {
+    //all members are internal, the struct is only public so it can be embedded, use the parrayValue functions instead
+    PARRAY_INT offset; //index of the first element in data
+    PARRAY_INT length; //number of elements
+    PARRAY_INT capacity; //number of elements data has room for
+    size_t size; //size of each element in bytes
+    const struct parray_allocator* alloc; //allocator used for all memory, NULL to use the PARRAY_* macros
+    char* data; //element buffer
+};
+struct parray_lookup; //forward declaration
+struct parray_hash; //forward declaration
+struct parray_share; //forward declaration
+struct parray_queue; //forward declaration
+struct parray {
+    //all members are internal, the struct is only public so it can be embedded, use the functions below instead
+    PARRAY_INT offset; //index of the first element in data
+    PARRAY_INT length; //number of elements
+    PARRAY_INT capacity; //number of elements data has room for
+    PARRAY_INT gap; //index of the element stored first in the ring while in gap mode, the gap lies right before it, else 0
+    int mode; //combination of mode flags
+    size_t released; //bytes given back by shrinking
+    const struct parray_allocator* alloc; //allocator used for all memory, NULL to use the PARRAY_* macros
+    struct parray_hash* hash; //element to index table while in index mode
+    struct parray_share* share; //reference count of data while it is shared with snapshots, NULL if owned outright
+    void** data; //element buffer, points to small while inline storage is used
+    #if PARRAY_SMALL > 0
+    void* small[PARRAY_SMALL]; //inline storage, a parray using it must not be copied by value
+    #endif
+};
 
 //function declarations
+PADEF void parrayInit(struct parray*);
+    //initializes the given caller-owned parray (e.g. embedded in a struct or on the stack) to an empty state
+PADEF void parrayDeinit(struct parray*);
+    //frees the internal data of given caller-owned parray, leaving it empty and reusable, but not the parray itself
+PADEF void parrayInitEx(struct parray*, const struct parray_allocator*);
+    //same as parrayInit but makes the parray use the given allocator (which must outlive it) for its internal data
+PADEF struct parray* parrayNewEx(const struct parray_allocator*);
+    //same as parrayNew but allocates the parray and all its internal data through the given allocator (must outlive it)
 PADEF struct parray* parrayNew();
     //creates a new parray instance and returns a pointer to it
-PADEF int parrayLength(const struct parray*);
+PADEF struct parray* parrayNewWithCapacity(PARRAY_INT);
+    //creates a new parray instance with room for at least the given number of elements, returns NULL on failure
+PADEF struct parray* parrayClone(const struct parray*);
+    //creates an independent copy of given parray using the same allocator and modes, with its elements contiguous in order
+    //and a capacity of exactly its length, allocating the struct and one buffer for the elements (none if they fit the
+    //inline buffer) and copying them with one memcpy per segment, NULL on failure, O(n)
+PADEF size_t parraySerialize(const struct parray*, const void*, void*, size_t);
+    //writes an image of given parray with its elements stored as offsets from given base (or as is if NULL) into the given
+    //buffer of given size, returns the size of the image, in which case nothing is written if that exceeds the buffer, O(n)
+PADEF int parrayLoad(struct parray*, const void*, size_t, const void*);
+    //replaces the elements of given parray with those in the given image of given size, adding back the given base (which
+    //must be NULL if and only if the image was written without one), returns 0 on success or -1 on failure, O(n)
+PADEF int parrayMapImage(struct parray*, const void*, size_t);
+    //initializes the given caller-owned parray like parrayInit as a read-only view of the elements in the given image of
+    //given size (aligned to a pointer), whose buffer stays owned by the caller and must outlive the parray, O(1)
+    //returns 0 on success, or -1 if the image is invalid or out of memory, the parray is left empty in that case
+#ifdef PARRAY_MMAP
+PADEF int parrayMapFile(struct parray*, const char*);
+    //same as parrayMapImage for the image stored in the file at given path, which is mapped read-only into memory and
+    //unmapped again once the parray and all snapshots of it are cleaned up, returns 0 on success or -1 on failure, O(1)
+#endif
+PADEF struct parray* parraySnapshot(struct parray*);
+    //creates a parray holding the same elements as given one by sharing its buffer, returns NULL on failure, O(1)
+    //the first modifying call on either copies the buffer first (O(n)), index mode isn't carried over to the snapshot
+    //a snapshot may be read and freed on another thread while the original is used, but not used by both at once
+PAINL PARRAY_INT parrayLength(const struct parray*);
     //returns the current number of elements in the given parray, O(1)
-PADEF int parraySet(struct parray*, int, void*);
+PAINL PARRAY_INT parraySet(struct parray*, PARRAY_INT, void*);
     //overwrites the element at given index in given parray with given value, O(1)
     //returns the index the value was placed at, or -1 on failure
-PADEF int parrayIndexOf(const struct parray*, void*);
-    //returns the index of given element in given parray, -1 if not found, O(n)
-PADEF void* parrayGet(const struct parray*, int);
+PADEF PARRAY_INT parrayIndexOf(const struct parray*, void*);
+    //returns the index of given element in given parray, -1 if not found, O(n) or O(1) on average in index mode
+PADEF int parrayContains(const struct parray*, void*);
+    //returns 1 if given element is in given parray, 0 otherwise, O(n) or O(1) on average in index mode
+PAINL void* parrayGet(const struct parray*, PARRAY_INT);
     //returns the element at the given index in given parray, or NULL if OOB, O(1)
-PADEF void* parrayGetFirst(const struct parray*);
+PAINL void* parrayGetFirst(const struct parray*);
     //returns the first element in the given parray, or NULL if empty, O(1)
-PADEF void* parrayGetLast(const struct parray*);
+PAINL void* parrayGetLast(const struct parray*);
     //returns the last element in the given parray, or NULL if empty, O(1)
+PAINL void* parrayGetUnchecked(const struct parray*, PARRAY_INT);
+    //same as parrayGet but without bounds checking, given index must be within the bounds of the parray, O(1)
+PAINL void parraySetUnchecked(struct parray*, PARRAY_INT, void*);
+    //same as parraySet but without bounds checking, given index must be within the bounds of the parray, O(1)
+PADEF void** parrayData(struct parray*);
+    //returns a pointer to the first element of given parray, followed by all others in order, valid until it is modified
+    //a wrapped ring is unwrapped first (O(n)), otherwise O(1), may return NULL if the parray is empty
+    //elements of a parray in index mode must not be modified through the returned pointer unless parrayReindex follows
+PADEF void parrayReindex(struct parray*);
+    //rebuilds the index of given parray in index mode after its elements were reordered through parrayData, else does
+    //nothing, leaves index mode if that fails, O(n)
 PADEF void parrayClear(struct parray*);
     //clears the given parray of all its elements (doesn't free any memory), O(1)
 PADEF void parrayFree(struct parray*);
     //frees the given parray (not NULL) and all its internal data
-PADEF int parrayPush(struct parray*, void*);
+PAINL PARRAY_INT parrayPush(struct parray*, void*);
     //appends the given element to the end of given parray (growing if needed), amortized O(1)
     //returns the index the element was placed at, or -1 on failure
 PADEF void* parrayPop(struct parray*);
     //removes the last element in given parray and returns it (NULL if empty), O(1)
 PADEF void* parrayDequeue(struct parray*);
     //removes the first element in given parray and returns it (NULL if empty), amortized O(1)
-PADEF int parrayFindIndex(const struct parray*, int(*)(const void*, const void**), const void*);
+PADEF PARRAY_INT parrayDequeueN(struct parray*, void**, PARRAY_INT);
+    //removes up to the given number of elements from the front of given parray, copying them in order into the given buffer
+    //returns the number of elements removed (0 if empty) or -1 if the given number is negative, O(n) in elements removed
+PADEF void** parrayDrain(struct parray*, PARRAY_INT*);
+    //removes the longest contiguous run of elements from the front of given parray without copying them, returning a pointer
+    //to it and storing its length through the given pointer, the run stays valid until the next modifying call on the parray
+    //a wrapped ring is drained in two runs, so call again until it returns NULL (with a length of 0) to empty the parray, O(1)
+PADEF PARRAY_INT parrayFindIndex(const struct parray*, int(*)(const void*, const void**), const void*);
     //returns the index of an element that evaluates as equal to given value according to given function, O(logn)
     //parray must be sorted for this function to work correctly, otherwise the result is undefined
+PADEF void parrayFindIndexBatch(const struct parray*, int(*)(const void*, const void**), const void* const*, PARRAY_INT, PARRAY_INT*);
+    //same as parrayFindIndex for each of the given number of keys at once, storing the results in given array, O(k*logn)
+    //but where several elements match a key the lowest matching index is stored, like parrayLowerBound would find it
+    //searches for several keys are interleaved with prefetching to overlap their cache misses
 PADEF void* parrayFindElement(const struct parray*, int(*)(const void*, const void**), const void*);
     //returns an element that evaluates as equal to given value according to given comparison function, O(logn)
     //parray must be sorted for this function to work correctly, otherwise the result is undefined
+PADEF PARRAY_INT parrayLowerBound(const struct parray*, int(*)(const void*, const void**), const void*);
+    //returns the index of the first element that doesn't evaluate as smaller than given value (length if none), O(logn)
+    //parray must be sorted for this function to work correctly, otherwise the result is undefined
+PADEF PARRAY_INT parrayUpperBound(const struct parray*, int(*)(const void*, const void**), const void*);
+    //returns the index of the first element that evaluates as greater than given value (length if none), O(logn)
+    //parray must be sorted for this function to work correctly, otherwise the result is undefined
+PADEF PARRAY_INT parraySortedInsert(struct parray*, int(*)(const void**, const void**), void*);
+    //inserts the given element after all elements that don't evaluate as greater than it, keeping the parray sorted, O(n)
+    //returns the index the element was placed at, or -1 on failure
+PADEF void* parraySortedRemove(struct parray*, int(*)(const void*, const void**), const void*);
+    //removes and returns the first element that evaluates as equal to given value, keeping the parray sorted, O(n)
+    //returns NULL if no such element is found, parray must be sorted for this function to work correctly
+PADEF struct parray_lookup* parrayLookupNew(const struct parray*, uint64_t(*)(const void*));
+    //builds a read-only search index over given parray using the keys returned by given function, returns NULL on failure
+    //parray must be sorted by these keys smallest to greatest for the index to work correctly, O(n)
+PADEF PARRAY_INT parrayLookupFind(const struct parray_lookup*, uint64_t);
+    //returns the index in the original parray of the first element with given key, or -1 if there is none, O(logn)
+PADEF PARRAY_INT parrayLookupLowerBound(const struct parray_lookup*, uint64_t);
+    //returns the index in the original parray of the first element with a key not smaller than given key, O(logn)
+    //returns the length the original parray had when the index was built if all keys are smaller
+PADEF void parrayLookupFree(struct parray_lookup*);
+    //frees the given search index (not NULL)
 PADEF void parraySortInsert(struct parray*, int(*)(const void**, const void**));
     //insertion sorts the elements in given parray according to given comparison function, O(n*n)
     //comparison function should return 1 if first argument is greater than second argument
     //0 if it is equal, and -1 if it is smaller, parray will be sorted smallest to greatest
 PADEF void parraySortStandard(struct parray*, int(*)(const void**, const void**));
-    //same as parraySortInsert but uses the C standard qsort function for sorting instead, O(n*logn)
-PADEF int parrayInsert(struct parray*, int, void*);
+    //same as parraySortInsert but uses an introsort instead, which is O(n) for already sorted parrays, O(n*logn) otherwise
+PADEF int parraySortParallel(struct parray*, int(*)(const void**, const void**), const struct parray_executor*);
+    //same as parraySortStandard but sorts chunks in parallel on given executor before merging them, O(n*logn)
+    //merging uses a temporary buffer the size of the elements, returns 0 on success or -1 on failure
+PADEF int parraySortByKey(struct parray*, uint64_t(*)(const void*));
+    //stably sorts the elements in given parray by the unsigned integer keys given function returns for them, O(n)
+    //each key is extracted only once into a temporary buffer holding two (key, element) pairs per element, -1 on failure
+PADEF PARRAY_INT parrayInsert(struct parray*, PARRAY_INT, void*);
     //inserts the given element at the given index in given parray, shifting other elements forward, O(n)
+    //in gap mode O(1) amortized plus the distance from the previous edit instead, see parray modes
     //returns the index the element was placed at, or -1 on failure
-PADEF void* parrayRemove(struct parray*, int);
+PADEF void* parrayRemove(struct parray*, PARRAY_INT);
     //removes and returns the element at given index while maintaining order of remaining elements, O(n)
-    //returns NULL if given index is outside the bounds of the parray
-PADEF void* parrayDitch(struct parray*, int);
+    //in gap mode O(1) amortized plus the distance from the previous edit instead, returns NULL if given index is outside the bounds of the parray
+PADEF void* parrayDitch(struct parray*, PARRAY_INT);
     //faster alternative to parrayRemove that doesn't maintain order of remaining elements, O(1)
-PADEF int parrayCapacity(struct parray*, int);
+    //returns the removed element, or NULL if OOB or if a buffer shared with a snapshot couldn't be copied
+PADEF PARRAY_INT parrayRemoveIf(struct parray*, int(*)(void*, void*), void*);
+    //removes all elements for which given predicate returns non-zero, passing each element and given context to it
+    //maintains order of remaining elements in a single pass, returns the number of elements removed or -1 on failure, O(n)
+PADEF PARRAY_INT parrayDitchIf(struct parray*, int(*)(void*, void*), void*);
+    //faster alternative to parrayRemoveIf that fills gaps with elements from the end instead of maintaining order, O(n)
+PADEF PARRAY_INT parrayCapacity(struct parray*, PARRAY_INT);
     //adjusts the internal capacity of the given parray to most closely match the given number of elements
     //returns the capacity after resizing, which may not match what was requested, or -1 on failure
+PADEF PARRAY_INT parrayPushN(struct parray*, void**, PARRAY_INT);
+    //appends the given number of elements from given array to the end of given parray (growing at most once), O(k)
+    //returns the index the first element was placed at, or -1 on failure
+PADEF PARRAY_INT parrayInsertN(struct parray*, PARRAY_INT, void**, PARRAY_INT);
+    //inserts the given number of elements from given array at given index (which may equal length), shifting once, O(n+k)
+    //returns the index the first element was placed at, or -1 on failure
+PADEF PARRAY_INT parrayRemoveRange(struct parray*, PARRAY_INT, void**, PARRAY_INT);
+    //removes the given number of elements starting at given index while maintaining order of remaining elements, O(n)
+    //removed elements are copied into given array unless it is NULL, returns number of elements removed, or -1 if OOB
+PADEF PARRAY_INT parrayPushFront(struct parray*, void*);
+    //prepends the given element to the start of given parray, O(1) if in ring mode or after dequeues, otherwise O(n)
+    //returns the index the element was placed at (always 0), or -1 on failure
+PADEF void parrayForEach(const struct parray*, void(*)(void*, void*), void*);
+    //calls given function on each element of given parray in order, passing it the element and given context, O(n)
+    //prefetches the memory elements point to PARRAY_PREFETCH_DISTANCE elements ahead, the parray must not be modified meanwhile
+PADEF PARRAY_INT parrayForEachRange(const struct parray*, PARRAY_INT, PARRAY_INT, void(*)(void*, void*), void*);
+    //same as parrayForEach but only for the given number of elements starting at given index, O(k)
+    //returns the number of elements visited, or -1 if OOB
+PADEF int parrayForEachBatch(const struct parray*, PARRAY_INT, void(*)(void* const*, PARRAY_INT, void*), void*);
+    //calls given function on consecutive runs of up to the given number of elements, passing it a pointer to the first, the
+    //number of elements in the run, and given context, prefetching what the next run points to before each call, O(n)
+    //returns 0 on success, or -1 if the given number is less than 1
+PADEF void parrayParallelForEach(const struct parray*, void(*)(void*, void*), void*, const struct parray_executor*, int);
+    //same as parrayForEach but splits the parray into chunks aligned to cache lines that are run on given executor, O(n)
+    //given function is called from several threads at once, in no particular order between chunks, and must be thread-safe
+    //the flags may be PARRAY_PARALLEL_DYNAMIC, making chunks much smaller so idle threads even out skewed per-element cost
+PADEF int parrayParallelReduce(const struct parray*, size_t, void*, void(*)(void*, void*, void*), void(*)(void*, const void*, void*), void*, const struct parray_executor*, int);
+    //folds all elements of given parray into the accumulator of given size pointed to, which must hold an identity value,
+    //calling fold(acc, ele, ctx) on a private copy of it per chunk, then combine(acc, part, ctx) on each copy in order
+    //chunks and flags are the same as in parrayParallelForEach, returns 0 on success or -1 on failure, O(n)
+PADEF int parrayMode(struct parray*, int);
+    //sets the mode flags (see parray modes) of given parray to the given combination, unwrapping it if needed, O(n)
+    //leaving gap mode closes the gap
+    //returns the previous mode flags of the parray, or -1 without changing them if the elements had to be moved but a
+    //buffer shared with a snapshot couldn't be copied
+PADEF PARRAY_INT parrayPushSlow(struct parray*, void*);
+    //internal out of line part of parrayPush that handles growth and wrap-around, do not call directly
+PADEF PARRAY_INT parraySetSlow(struct parray*, PARRAY_INT, void*);
+    //internal out of line part of parraySet that keeps the index up to date and unshares, do not call directly
+#ifdef PARRAY_THREADS
+PADEF void parrayRunThreads(const struct parray_executor*, void(*)(void*, int), void*, int);
+    //run function for struct parray_executor that spreads tasks over exec->threads threads, including the calling one
+#endif
+PADEF void parrayChunkedInit(struct parray_chunked*);
+    //initializes the given chunked parray, which must be cleaned up with parrayChunkedDeinit, O(1)
+PADEF void parrayChunkedDeinit(struct parray_chunked*);
+    //frees all chunks of the given chunked parray and reinitializes it, O(n)
+PADEF void parrayChunkedInitEx(struct parray_chunked*, const struct parray_allocator*);
+    //same as parrayChunkedInit but makes the chunked parray use the given allocator for all its memory, O(1)
+PADEF struct parray_chunked* parrayChunkedNewEx(const struct parray_allocator*);
+    //same as parrayChunkedNew but allocates and makes the chunked parray use the given allocator, returns NULL on failure, O(1)
+PADEF struct parray_chunked* parrayChunkedNew();
+    //returns a new empty chunked parray, or NULL on failure, O(1)
+PAINL PARRAY_INT parrayChunkedLength(const struct parray_chunked*);
+    //returns the number of elements in the given chunked parray, O(1)
+PAINL PARRAY_INT parrayChunkedSet(struct parray_chunked*, PARRAY_INT, void*);
+    //overwrites the element at given index in given chunked parray, returns the index or -1 if OOB, O(1)
+PAINL void* parrayChunkedGet(const struct parray_chunked*, PARRAY_INT);
+    //returns the element at given index in given chunked parray (NULL if OOB), O(1)
+PADEF void* parrayChunkedGetFirst(const struct parray_chunked*);
+    //returns the first element in given chunked parray (NULL if empty), O(1)
+PADEF void* parrayChunkedGetLast(const struct parray_chunked*);
+    //returns the last element in given chunked parray (NULL if empty), O(1)
+PADEF void** parrayChunkedAddress(struct parray_chunked*, PARRAY_INT);
+    //returns the address of the element at given index (NULL if OOB), which stays valid until the element is moved by
+    //inserting or removing elements before it, or freed by removing it and shrinking the capacity, O(1)
+PADEF PARRAY_INT parrayChunkedIndexOf(const struct parray_chunked*, void*);
+    //returns the index of given element in given chunked parray, -1 if not found, O(n)
+PADEF void parrayChunkedClear(struct parray_chunked*);
+    //clears the given chunked parray of all elements, keeping its chunks for reuse, O(1)
+PADEF void parrayChunkedFree(struct parray_chunked*);
+    //frees the given chunked parray, elements aren't freed, O(n)
+PADEF PARRAY_INT parrayChunkedPush(struct parray_chunked*, void*);
+    //appends the given element to the end of given chunked parray, never moving others, O(1) amortized over the directory
+    //returns the index the element was placed at, or -1 on failure
+PADEF void* parrayChunkedPop(struct parray_chunked*);
+    //removes the last element in given chunked parray and returns it (NULL if empty), O(1)
+PADEF void* parrayChunkedDequeue(struct parray_chunked*);
+    //removes the first element in given chunked parray and returns it (NULL if empty), O(1) or O(n/chunk) if a chunk empties
+PADEF PARRAY_INT parrayChunkedInsert(struct parray_chunked*, PARRAY_INT, void*);
+    //inserts the given element at given index while maintaining order of existing elements, O(chunk+n/chunk)
+    //returns the index the element was placed at, or -1 on failure or if OOB
+PADEF void* parrayChunkedRemove(struct parray_chunked*, PARRAY_INT);
+    //removes the element at given index while maintaining order of remaining elements, O(chunk+n/chunk)
+    //returns the removed element, or NULL if OOB
+PADEF void* parrayChunkedDitch(struct parray_chunked*, PARRAY_INT);
+    //faster alternative to parrayChunkedRemove that doesn't maintain order of remaining elements, O(1)
+PADEF PARRAY_INT parrayChunkedCapacity(struct parray_chunked*, PARRAY_INT);
+    //allocates or frees unused chunks so the given chunked parray has room for at least the given number of elements, O(n/chunk)
+    //returns the resulting capacity, or -1 on failure
+PADEF void parrayValueInit(struct parray_value*, size_t);
+    //initializes the given value parray for elements of the given size in bytes (not 0), which must be cleaned up with
+    //parrayValueDeinit, O(1)
+PADEF void parrayValueDeinit(struct parray_value*);
+    //frees the buffer of the given value parray and reinitializes it for elements of the same size, O(1)
+PADEF void parrayValueInitEx(struct parray_value*, size_t, const struct parray_allocator*);
+    //same as parrayValueInit but makes the value parray use the given allocator for its buffer, O(1)
+PADEF struct parray_value* parrayValueNewEx(size_t, const struct parray_allocator*);
+    //same as parrayValueNew but allocates and makes the value parray use the given allocator, returns NULL on failure, O(1)
+PADEF struct parray_value* parrayValueNew(size_t);
+    //returns a new empty value parray for elements of the given size in bytes (not 0), or NULL on failure, O(1)
+PAINL PARRAY_INT parrayValueLength(const struct parray_value*);
+    //returns the number of elements in the given value parray, O(1)
+PAINL void* parrayValueGet(const struct parray_value*, PARRAY_INT);
+    //returns the address of the element at given index in given value parray (NULL if OOB), O(1)
+    //the address is valid until the next modifying call, elements may be changed through it
+PADEF PARRAY_INT parrayValueSet(struct parray_value*, PARRAY_INT, const void*);
+    //copies the element pointed to into the given index of given value parray, returns the index or -1 if OOB, O(1)
+PADEF void* parrayValueGetFirst(const struct parray_value*);
+    //returns the address of the first element in given value parray (NULL if empty), O(1)
+PADEF void* parrayValueGetLast(const struct parray_value*);
+    //returns the address of the last element in given value parray (NULL if empty), O(1)
+PADEF void* parrayValueData(struct parray_value*);
+    //returns the address of the first element of given value parray, followed by all others in order, O(1)
+    //valid until the next modifying call, may return NULL if the value parray is empty
+PADEF void parrayValueClear(struct parray_value*);
+    //clears the given value parray of all its elements (doesn't free any memory), O(1)
+PADEF void parrayValueFree(struct parray_value*);
+    //frees the given value parray (not NULL) and its buffer
+PADEF PARRAY_INT parrayValuePush(struct parray_value*, const void*);
+    //appends a copy of the element pointed to, which must not lie within the value parray itself, amortized O(1)
+    //returns the index the element was placed at, or -1 on failure
+PADEF int parrayValuePop(struct parray_value*, void*);
+    //removes the last element of given value parray, copying it to the given address unless it is NULL, O(1)
+    //returns 0 on success, or -1 if empty
+PADEF int parrayValueDequeue(struct parray_value*, void*);
+    //removes the first element of given value parray, copying it to the given address unless it is NULL, amortized O(1)
+    //returns 0 on success, or -1 if empty
+PADEF PARRAY_INT parrayValueInsert(struct parray_value*, PARRAY_INT, const void*);
+    //inserts a copy of the element pointed to (not within the value parray) at given index, shifting others forward, O(n)
+    //returns the index the element was placed at, or -1 on failure
+PADEF int parrayValueRemove(struct parray_value*, PARRAY_INT, void*);
+    //removes the element at given index while maintaining order, copying it to the given address unless it is NULL, O(n)
+    //returns 0 on success, or -1 if OOB
+PADEF int parrayValueDitch(struct parray_value*, PARRAY_INT, void*);
+    //faster alternative to parrayValueRemove that moves the last element into the hole instead of maintaining order, O(1)
+PADEF void parrayValueSortStandard(struct parray_value*, int(*)(const void*, const void*));
+    //sorts the elements in given value parray with the standard qsort using given function on element addresses, O(n*logn)
+PADEF PARRAY_INT parrayValueFindIndex(const struct parray_value*, int(*)(const void*, const void*), const void*);
+    //returns the index of an element that evaluates as equal to given key according to given function, O(logn)
+    //the function gets the key and an element address, value parray must be sorted for this to work correctly
+PADEF void* parrayValueFindElement(const struct parray_value*, int(*)(const void*, const void*), const void*);
+    //same as parrayValueFindIndex but returns the address of the element found (NULL if none), O(logn)
+PADEF PARRAY_INT parrayValueLowerBound(const struct parray_value*, int(*)(const void*, const void*), const void*);
+    //returns the index of the first element that doesn't evaluate as smaller than given key (length if none), O(logn)
+    //value parray must be sorted for this function to work correctly, otherwise the result is undefined
+PADEF PARRAY_INT parrayValueCapacity(struct parray_value*, PARRAY_INT);
+    //adjusts the internal capacity of the given value parray to most closely match the given number of elements
+    //returns the capacity after resizing, or -1 on failure
+#ifdef PARRAY_MMAP
+PADEF void* parrayMmapAlloc(void*, void*, size_t, size_t);
+    //allocator function for struct parray_allocator whose user pointer must point to a struct parray_mmap that outlives it
+#endif
+#ifdef PARRAY_QUEUE
+PADEF struct parray_queue* parrayQueueNew(PARRAY_INT, int);
+    //creates a concurrent queue with room for at least the given number of elements and the given combination of flags
+    //PARRAY_QUEUE_SPSC restricts it to one pushing and one dequeuing thread, PARRAY_QUEUE_GROW lets it grow when full
+    //returns NULL on failure
+PADEF struct parray_queue* parrayQueueNewEx(PARRAY_INT, int, const struct parray_allocator*);
+    //same as parrayQueueNew but using the given allocator, which must be safe to call from all pushing threads if growable
+PADEF int parrayQueuePush(struct parray_queue*, void*);
+    //appends the given element to the end of given queue, lock-free, O(1) unless growing
+    //returns 0 on success, or -1 if a fixed size queue is full or growing failed
+PADEF void* parrayQueueDequeue(struct parray_queue*);
+    //removes the first element in given queue and returns it (NULL if empty), lock-free, O(1)
+PADEF PARRAY_INT parrayQueueLength(struct parray_queue*);
+    //returns the number of elements in given queue, which is only a snapshot while other threads use it, O(1) unless grown
+PADEF void parrayQueueFree(struct parray_queue*);
+    //frees the given queue, which must no longer be in use by other threads, elements still in it aren't freed
+#endif
+PADEF size_t parrayReleased(const struct parray*);
+    //returns the total number of bytes given back by shrinking the given parray, automatically or through parrayCapacity
+#ifdef __cplusplus
+}
+#endif
+
+//c++ wrapper
+#ifdef __cplusplus
+namespace pa {
+    template <typename T> class array; //only defined for pointer element types
+    template <typename T> class array<T*> {
+        //owning wrapper whose only member is a struct parray, so instances can be shared with c code through raw()
+        struct parray parr;
+        void take (array& other) noexcept {
+            //moves the contents of given array into this uninitialized one, leaving the other one empty
+            parr = other.parr;
+            #if PARRAY_SMALL > 0
+            if (other.parr.data == other.parr.small) parr.data = parr.small;
+            #endif
+            parrayInitEx(&other.parr, other.parr.alloc);
+        }
+        template <typename P> static int test (void* ele, void* ctx) {
+            return (*static_cast<P*>(ctx))(static_cast<T*>(ele)) ? 1 : 0;
+        }
+        template <typename F> static void visit (void* const* eles, PARRAY_INT num, void* ctx) {
+            for (PARRAY_INT i = 0; i < num; i++) (*static_cast<F*>(ctx))(static_cast<T*>(eles[i]));
+        }
+        #define PARRAY_CPP_LESS(A, B) ((*ctx)((A), (B)))
+        template <typename L> PARRAY_SORT_ENGINE(T, engine, PARRAY_CPP_LESS, const L*)
+        #undef PARRAY_CPP_LESS
+    public:
+        array () noexcept {parrayInit(&parr);}
+        explicit array (const struct parray_allocator* alloc) noexcept {parrayInitEx(&parr, alloc);}
+        array (array&& other) noexcept {take(other);}
+        array& operator= (array&& other) noexcept {
+            if (this != &other) {parrayDeinit(&parr); take(other);}
+            return *this;
+        }
+        array (const array&) = delete;
+        array& operator= (const array&) = delete;
+        ~array () {parrayDeinit(&parr);}
+        static array& wrap (struct parray* parr) noexcept {return *reinterpret_cast<array*>(parr);}
+        struct parray* raw () noexcept {return &parr;}
+        const struct parray* raw () const noexcept {return &parr;}
+        PARRAY_INT size () const noexcept {return parrayLength(&parr);}
+        bool empty () const noexcept {return !parrayLength(&parr);}
+        T* operator[] (PARRAY_INT ind) const noexcept {return static_cast<T*>(parrayGetUnchecked(&parr, ind));}
+        T* get (PARRAY_INT ind) const noexcept {return static_cast<T*>(parrayGet(&parr, ind));}
+        T* first () const noexcept {return static_cast<T*>(parrayGetFirst(&parr));}
+        T* last () const noexcept {return static_cast<T*>(parrayGetLast(&parr));}
+        PARRAY_INT set (PARRAY_INT ind, T* ele) noexcept {return parraySet(&parr, ind, ele);}
+        PARRAY_INT push (T* ele) noexcept {return parrayPush(&parr, ele);}
+        PARRAY_INT push_front (T* ele) noexcept {return parrayPushFront(&parr, ele);}
+        T* pop () noexcept {return static_cast<T*>(parrayPop(&parr));}
+        T* dequeue () noexcept {return static_cast<T*>(parrayDequeue(&parr));}
+        PARRAY_INT insert (PARRAY_INT ind, T* ele) noexcept {return parrayInsert(&parr, ind, ele);}
+        T* remove (PARRAY_INT ind) noexcept {return static_cast<T*>(parrayRemove(&parr, ind));}
+        T* ditch (PARRAY_INT ind) noexcept {return static_cast<T*>(parrayDitch(&parr, ind));}
+        PARRAY_INT index_of (T* ele) const noexcept {return parrayIndexOf(&parr, ele);}
+        bool contains (T* ele) const noexcept {return parrayContains(&parr, ele) != 0;}
+        void clear () noexcept {parrayClear(&parr);}
+        PARRAY_INT capacity (PARRAY_INT cap) noexcept {return parrayCapacity(&parr, cap);}
+        int mode (int mode) noexcept {return parrayMode(&parr, mode);}
+        T** data () noexcept {return reinterpret_cast<T**>(parrayData(&parr));}
+        T** begin () noexcept {return data();}
+        T** end () noexcept {return data()+size();}
+        template <typename L> void sort (L less) {
+            //less(a, b) returns true if a is smaller than b, and is inlined into the same introsort PARRAY_SORT uses
+            T** items = data();
+            if (!items) return;
+            engine<L>(items, size(), &less);
+            parrayReindex(&parr);
+        }
+        template <typename P> PARRAY_INT find_if (P pred) const {
+            //returns the index of the first element for which pred returns true, or -1 if there is none, O(n)
+            for (PARRAY_INT i = 0, len = size(); i < len; i++) if (pred((*this)[i])) return i;
+            return -1;
+        }
+        template <typename K, typename C> PARRAY_INT lower_bound (const K& key, C comp) const {
+            //same as parrayLowerBound, but comp(key, ele) returns a negative, zero, or positive int and is inlined, O(logn)
+            PARRAY_INT lo = 0, hi = size();
+            while (lo < hi) {
+                PARRAY_INT mid = lo+(hi-lo)/2;
+                if (comp(key, (*this)[mid]) > 0) lo = mid+1;
+                else hi = mid;
+            }
+            return lo;
+        }
+        template <typename K, typename C> PARRAY_INT find (const K& key, C comp) const {
+            //same as parrayFindIndex but with comp as in lower_bound, returns the first matching index or -1, O(logn)
+            PARRAY_INT ind = lower_bound(key, comp);
+            return ((ind < size())&&(!comp(key, (*this)[ind]))) ? ind : -1;
+        }
+        template <typename F> void for_each (F fn) const {
+            //same as parrayForEach with fn(ele) inlined, runs of 16 elements are prefetched while the previous one is visited
+            parrayForEachBatch(&parr, 16, visit<F>, &fn);
+        }
+        template <typename P> PARRAY_INT remove_if (P pred) {
+            //same as parrayRemoveIf with pred(ele) returning true for elements to remove
+            return parrayRemoveIf(&parr, test<P>, &pred);
+        }
+    };
+}
+#endif
 
 #endif //PARRAY_H
 
+//inline section
+#if (defined(PARRAY_INLINE) && !defined(PARRAY_INLINE_H)) || (!defined(PARRAY_INLINE) && defined(PARRAY_IMPLEMENTATION))
+#define PARRAY_INLINE_H
+
+//internal functions
+static inline PARRAY_INT parrayRingAt (const struct parray* parr, PARRAY_INT ind) {
+    //returns the position in data of the element given number of places into the ring, accounting for wrap-around
+    PARRAY_INT tail = parr->capacity-parr->offset; //positions from offset to the end of data, subtracted to avoid overflow
+    return (ind < tail) ? parr->offset+ind : ind-tail;
+}
+static inline PARRAY_INT parrayAt (const struct parray* parr, PARRAY_INT ind) {
+    //returns the position in data of the element at given index, accounting for the gap and ring wrap-around
+    if (parr->gap) ind = (ind < parr->gap) ? ind+(parr->length-parr->gap) : ind-parr->gap;
+    return parrayRingAt(parr, ind);
+}
+
+//accessor functions
+PAINL PARRAY_INT parrayLength (const struct parray* parr) {
+    return parr->length;
+}
+PAINL PARRAY_INT parraySet (struct parray* parr, PARRAY_INT ind, void* ele) {
+    if ((ind < 0)||(ind >= parr->length)) return -1;
+    if ((parr->hash)||(parr->share)) return parraySetSlow(parr, ind, ele);
+    parr->data[parrayAt(parr, ind)] = ele;
+    return ind;
+}
+PAINL void* parrayGet (const struct parray* parr, PARRAY_INT ind) {
+    if ((ind < 0)||(ind >= parr->length)) return NULL;
+    return parr->data[parrayAt(parr, ind)];
+}
+PAINL void* parrayGetFirst (const struct parray* parr) {
+    if (!parr->length) return NULL;
+    return parr->data[parrayAt(parr, 0)];
+}
+PAINL void* parrayGetLast (const struct parray* parr) {
+    if (!parr->length) return NULL;
+    return parr->data[parrayAt(parr, parr->length-1)];
+}
+PAINL void* parrayGetUnchecked (const struct parray* parr, PARRAY_INT ind) {
+    return parr->data[parrayAt(parr, ind)];
+}
+PAINL void parraySetUnchecked (struct parray* parr, PARRAY_INT ind, void* ele) {
+    if ((parr->hash)||(parr->share)) parraySetSlow(parr, ind, ele);
+    else parr->data[parrayAt(parr, ind)] = ele;
+}
+PAINL PARRAY_INT parrayPush (struct parray* parr, void* ele) {
+    //there is room right past the tail unless the parray is full, wrapped, shared, or has its gap elsewhere
+    if ((parr->length < parr->capacity-parr->offset)&&(!parr->hash)&&(!parr->gap)&&(!parr->share)) {
+        parr->data[parr->offset+parr->length] = ele;
+        return parr->length++;
+    }
+    return parrayPushSlow(parr, ele);
+}
+PAINL PARRAY_INT parrayChunkedLength (const struct parray_chunked* arr) {
+    return arr->length;
+}
+PAINL PARRAY_INT parrayChunkedSet (struct parray_chunked* arr, PARRAY_INT ind, void* ele) {
+    if ((ind < 0)||(ind >= arr->length)) return -1;
+    PARRAY_INT pos = arr->offset+ind, mask = ((PARRAY_INT)1 << PARRAY_CHUNK_BITS)-1;
+    struct parray_chunk* chunk = &arr->dir[pos >> PARRAY_CHUNK_BITS];
+    chunk->data[(chunk->head+pos) & mask] = ele;
+    return ind;
+}
+PAINL void* parrayChunkedGet (const struct parray_chunked* arr, PARRAY_INT ind) {
+    if ((ind < 0)||(ind >= arr->length)) return NULL;
+    PARRAY_INT pos = arr->offset+ind, mask = ((PARRAY_INT)1 << PARRAY_CHUNK_BITS)-1;
+    const struct parray_chunk* chunk = &arr->dir[pos >> PARRAY_CHUNK_BITS];
+    return chunk->data[(chunk->head+pos) & mask];
+}
+PAINL PARRAY_INT parrayValueLength (const struct parray_value* arr) {
+    return arr->length;
+}
+PAINL void* parrayValueGet (const struct parray_value* arr, PARRAY_INT ind) {
+    if ((ind < 0)||(ind >= arr->length)) return NULL;
+    return arr->data+arr->size*(size_t)(arr->offset+ind);
+}
+
+#endif //PARRAY_INLINE_H
+
 //implementation section
 #ifdef PARRAY_IMPLEMENTATION
 #undef PARRAY_IMPLEMENTATION
@@ -188,168 +1192,1765 @@ PADEF int parrayCapacity(struct parray*, int);
 #ifndef PARRAY_FREE
     #define PARRAY_FREE(P) free(P)
 #endif
+#ifndef PARRAY_MIN_CAPACITY
+    #define PARRAY_MIN_CAPACITY 1
+#endif
+#ifndef PARRAY_GROWTH_FACTOR
+    #define PARRAY_GROWTH_FACTOR 2.0
+#endif
+#ifndef PARRAY_MAX_GROWTH
+    #define PARRAY_MAX_GROWTH 0
+#endif
+#ifndef PARRAY_PARALLEL_MIN
+    #define PARRAY_PARALLEL_MIN 65536
+#endif
+#ifndef PARRAY_BATCH
+    #define PARRAY_BATCH 8
+#endif
+#ifndef PARRAY_PREFETCH_DISTANCE
+    #define PARRAY_PREFETCH_DISTANCE 8
+#endif
+#ifndef PARRAY_PREFETCH
+    #if defined(__GNUC__) || defined(__clang__)
+        #define PARRAY_PREFETCH(P) __builtin_prefetch(P)
+    #else
+        #define PARRAY_PREFETCH(P) ((void)(P))
+    #endif
+#endif
+#define PARRAY_CAPACITY_LIMIT ((PARRAY_INT)(((size_t)PARRAY_INT_MAX < SIZE_MAX/sizeof(void*)) ? (size_t)PARRAY_INT_MAX : SIZE_MAX/sizeof(void*)))
+#if PARRAY_SMALL > 0
+    #define PARRAY_SMALL_DATA(P) ((P)->small)
+    #define PARRAY_IS_SMALL(P) ((P)->data == (P)->small)
+#else
+    #define PARRAY_SMALL_DATA(P) NULL
+    #define PARRAY_IS_SMALL(P) 0
+#endif
 
 //includes
 #include <stdlib.h> //memory allocation
-#include <string.h> //memmove/memcpy
+#include <string.h> //memmove/memcpy/memset
+#ifdef PARRAY_THREADS
+    #include <pthread.h> //threads
+#endif
+#ifdef PARRAY_MMAP
+    #include <sys/mman.h> //mmap
+    #include <unistd.h> //sysconf, close
+    #include <fcntl.h> //open
+    #include <sys/stat.h> //fstat
+#endif
+#ifdef PARRAY_QUEUE
+    #if defined(__STDC_NO_ATOMICS__) || !defined(__STDC_VERSION__) || (__STDC_VERSION__ < 201112L)
+        #error "PARRAY_QUEUE requires C11 atomics"
+    #endif
+    #include <stdatomic.h> //atomics
+#endif
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+    #include <stdatomic.h> //atomic reference counts
+    #define PARRAY_REFS atomic_size_t
+    #define PARRAY_REFS_INIT(R, N) atomic_init(R, N)
+    #define PARRAY_REFS_LOAD(R) atomic_load_explicit(R, memory_order_acquire)
+    #define PARRAY_REFS_ADD(R) atomic_fetch_add_explicit(R, 1, memory_order_relaxed)
+    #define PARRAY_REFS_SUB(R) atomic_fetch_sub_explicit(R, 1, memory_order_acq_rel)
+#elif defined(__GNUC__) || defined(__clang__)
+    #define PARRAY_REFS size_t
+    #define PARRAY_REFS_INIT(R, N) (*(R) = (N))
+    #define PARRAY_REFS_LOAD(R) __atomic_load_n(R, __ATOMIC_ACQUIRE)
+    #define PARRAY_REFS_ADD(R) __atomic_fetch_add(R, 1, __ATOMIC_RELAXED)
+    #define PARRAY_REFS_SUB(R) __atomic_fetch_sub(R, 1, __ATOMIC_ACQ_REL)
+#else
+    //without atomics snapshots are only safe to use on the thread that took them
+    #define PARRAY_REFS size_t
+    #define PARRAY_REFS_INIT(R, N) (*(R) = (N))
+    #define PARRAY_REFS_LOAD(R) (*(R))
+    #define PARRAY_REFS_ADD(R) ((*(R))++)
+    #define PARRAY_REFS_SUB(R) ((*(R))--)
+#endif
+#if !defined(PARRAY_NO_SIMD) && (UINTPTR_MAX == 0xFFFFFFFFFFFFFFFFu)
+    #if defined(__AVX2__)
+        #include <immintrin.h> //avx2 intrinsics
+        #define PARRAY_SIMD_AVX2
+    #elif defined(__SSE2__) || defined(_M_X64)
+        #include <emmintrin.h> //sse2 intrinsics
+        #define PARRAY_SIMD_SSE2
+    #elif defined(__aarch64__) || defined(_M_ARM64)
+        #include <arm_neon.h> //neon intrinsics
+        #define PARRAY_SIMD_NEON
+    #endif
+#endif
 
-//structs
-struct parray {
-    int offset;
-    int length;
-    int capacity;
-    void** data;
+
+//internal functions
+static void* parrayRealloc (const struct parray_allocator* alloc, void* ptr, size_t old, size_t size) {
+    //routes memory management through given allocator, or the macros if there is none
+    if (alloc) return alloc->alloc(alloc->user, ptr, old, size);
+    if (size) return PARRAY_REALLOC(ptr, size);
+    PARRAY_FREE(ptr);
+    return NULL;
+}
+static PARRAY_INT parrayScan (void* const* data, PARRAY_INT num, const void* ele) {
+    //returns the index of the first occurrence of given element in given contiguous range, or -1 if there is none
+    PARRAY_INT i = 0;
+    #if defined(PARRAY_SIMD_AVX2)
+    __m256i key = _mm256_set1_epi64x((long long)(uintptr_t)ele);
+    for (; i+16 <= num; i += 16) {
+        __m256i a = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)&data[i]), key);
+        __m256i b = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)&data[i+4]), key);
+        __m256i c = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)&data[i+8]), key);
+        __m256i d = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)&data[i+12]), key);
+        if (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d))))) break;
+    }
+    #elif defined(PARRAY_SIMD_SSE2)
+    //sse2 lacks 64 bit compares, so only the low halves are compared and candidates are checked one by one
+    __m128i key = _mm_set1_epi64x((long long)(uintptr_t)ele);
+    for (; i+8 <= num; i += 8) {
+        __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&data[i]), key);
+        __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&data[i+2]), key);
+        __m128i c = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&data[i+4]), key);
+        __m128i d = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&data[i+6]), key);
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) & 0x0F0F)
+            for (PARRAY_INT j = i; j < i+8; j++) if (data[j] == ele) return j;
+    }
+    #elif defined(PARRAY_SIMD_NEON)
+    uint64x2_t key = vdupq_n_u64((uint64_t)(uintptr_t)ele);
+    for (; i+8 <= num; i += 8) {
+        uint64x2_t a = vceqq_u64(vld1q_u64((const uint64_t*)&data[i]), key);
+        uint64x2_t b = vceqq_u64(vld1q_u64((const uint64_t*)&data[i+2]), key);
+        uint64x2_t c = vceqq_u64(vld1q_u64((const uint64_t*)&data[i+4]), key);
+        uint64x2_t d = vceqq_u64(vld1q_u64((const uint64_t*)&data[i+6]), key);
+        if (vmaxvq_u32(vreinterpretq_u32_u64(vorrq_u64(vorrq_u64(a, b), vorrq_u64(c, d))))) break;
+    }
+    #endif
+    //handles the remainder as well as pinpointing a match found above
+    for (; i < num; i++)
+        if (data[i] == ele) return i;
+    return -1;
+}
+static void parrayReverse (void** data, PARRAY_INT num) {
+    for (PARRAY_INT i = 0, j = num-1; i < j; i++, j--) {
+        void* temp = data[i];
+        data[i] = data[j];
+        data[j] = temp;
+    }
+}
+static void parrayUnwrap (struct parray* parr) {
+    //makes the elements of a wrapped ring contiguous again by rotating the whole buffer in place
+    if (parr->length <= parr->capacity-parr->offset) return;
+    parrayReverse(&parr->data[0], parr->offset);
+    parrayReverse(&parr->data[parr->offset], parr->capacity-parr->offset);
+    parrayReverse(&parr->data[0], parr->capacity);
+    parr->offset = 0;
+}
+static void parrayGapMove (struct parray* parr, PARRAY_INT ind) {
+    //moves the gap right before the element at given index (or to the end at length), rotating the ring one step per index
+    //each step moves an element across the free space from one end of the ring to the other, going the shorter way around
+    PARRAY_INT len = parr->length, dist = ((ind == len) ? 0 : ind)-parr->gap;
+    if (dist < 0) dist += len;
+    if (dist <= len-dist) {
+        for (; dist > 0; dist--) {
+            parr->data[parrayRingAt(parr, len)] = parr->data[parr->offset];
+            if (++parr->offset == parr->capacity) parr->offset = 0;
+        }
+    } else {
+        for (dist = len-dist; dist > 0; dist--) {
+            parr->offset = parr->offset ? parr->offset-1 : parr->capacity-1;
+            parr->data[parr->offset] = parr->data[parrayRingAt(parr, len)];
+        }
+    }
+    parr->gap = (ind == len) ? 0 : ind;
+}
+static void parrayLinear (struct parray* parr) {
+    //closes the gap and unwraps the ring, leaving the elements contiguous in index order from offset
+    if (parr->gap) parrayGapMove(parr, 0);
+    parrayUnwrap(parr);
+}
+static PARRAY_INT parrayScanRing (const struct parray* parr, PARRAY_INT lo, PARRAY_INT hi, const void* ele) {
+    //returns the place in the ring of the first occurrence of given element between given places, or -1 if there is none
+    //a wrapped ring is scanned as two contiguous segments
+    PARRAY_INT tail = parr->capacity-parr->offset, ind;
+    if (lo < tail) {
+        PARRAY_INT end = (hi < tail) ? hi : tail;
+        if ((ind = parrayScan(&parr->data[parr->offset+lo], end-lo, ele)) >= 0) return lo+ind;
+        lo = end;
+    }
+    if ((lo < hi)&&((ind = parrayScan(&parr->data[lo-tail], hi-lo, ele)) >= 0)) return lo+ind;
+    return -1;
+}
+static PARRAY_INT parrayRun (const struct parray* parr, PARRAY_INT ind, PARRAY_INT num) {
+    //returns how many of the given number of elements from given index on are stored contiguously, ending at wrap or gap
+    PARRAY_INT run = parr->capacity-parrayAt(parr, ind);
+    if ((ind < parr->gap)&&(parr->gap-ind < run)) run = parr->gap-ind;
+    return (num < run) ? num : run;
+}
+struct parray_share {
+    PARRAY_REFS refs; //number of parrays using the buffer, which all have the same capacity and allocator
+    int borrowed; //set if the buffer wasn't allocated by parray, in which case it's never freed or written
+    void* map; //file mapping the buffer lies in, unmapped along with the last reference, NULL if none
+    size_t size; //size of the mapping
 };
+static void parrayRelease (struct parray* parr) {
+    //gives up the reference given parray holds on its shared buffer, freeing the buffer if it was the last one
+    if (PARRAY_REFS_SUB(&parr->share->refs) == 1) {
+        #ifdef PARRAY_MMAP
+        if (parr->share->map) munmap(parr->share->map, parr->share->size);
+        #endif
+        if (!parr->share->borrowed) parrayRealloc(parr->alloc, parr->data, sizeof(parr->data[0])*parr->capacity, 0);
+        parrayRealloc(parr->alloc, parr->share, sizeof(struct parray_share), 0);
+    }
+    parr->share = NULL;
+}
+static int parrayWrite (struct parray* parr) {
+    //makes sure given parray owns its buffer before it is modified, copying a shared buffer, returns 0 on success
+    if (!parr->share) return 0;
+    if ((!parr->share->borrowed)&&(PARRAY_REFS_LOAD(&parr->share->refs) == 1)) {
+        //every other sharer has let go already
+        parrayRealloc(parr->alloc, parr->share, sizeof(struct parray_share), 0);
+        parr->share = NULL;
+        return 0;
+    }
+    //only the positions holding elements are copied, so that offset, wrap-around and gap stay valid
+    void** ndat = parrayRealloc(parr->alloc, NULL, 0, sizeof(parr->data[0])*parr->capacity);
+    if (!ndat) return -1;
+    PARRAY_INT head = (parr->length > parr->capacity-parr->offset) ? parr->capacity-parr->offset : parr->length;
+    memcpy(&ndat[parr->offset], &parr->data[parr->offset], sizeof(parr->data[0])*head);
+    memcpy(ndat, parr->data, sizeof(parr->data[0])*(parr->length-head));
+    parrayRelease(parr);
+    parr->data = ndat;
+    return 0;
+}
+static int parrayResize (struct parray* parr, PARRAY_INT cap) {
+    //reallocates the buffer of given parray to given capacity, moving the head segment to the end if wrapped
+    if ((cap < 0)||(cap > PARRAY_CAPACITY_LIMIT)) return -1;
+    if (cap <= PARRAY_SMALL) {
+        //fall back to the inline buffer, or to no buffer at all if there is none
+        if (PARRAY_IS_SMALL(parr)) return 0;
+        #if PARRAY_SMALL > 0
+        //callers shrinking this far have already unwrapped the parray
+        memcpy(parr->small, &parr->data[parr->offset], sizeof(parr->data[0])*parr->length);
+        #endif
+        parr->released += sizeof(parr->data[0])*parr->capacity;
+        parrayRealloc(parr->alloc, parr->data, sizeof(parr->data[0])*parr->capacity, 0);
+        parr->data = PARRAY_SMALL_DATA(parr);
+        parr->offset = 0; parr->capacity = PARRAY_SMALL;
+        return 0;
+    }
+    void** ndat = PARRAY_IS_SMALL(parr) ? parrayRealloc(parr->alloc, NULL, 0, sizeof(parr->data[0])*cap)
+        : parrayRealloc(parr->alloc, parr->data, sizeof(parr->data[0])*parr->capacity, sizeof(parr->data[0])*cap);
+    //check for realloc failure
+    if (!ndat) return -1;
+    if (PARRAY_IS_SMALL(parr)) memcpy(ndat, parr->data, sizeof(parr->data[0])*parr->capacity);
+    parr->data = ndat;
+    if (cap < parr->capacity) parr->released += sizeof(parr->data[0])*(parr->capacity-cap);
+    if (parr->length > parr->capacity-parr->offset) {
+        PARRAY_INT head = parr->capacity-parr->offset;
+        memmove(&parr->data[cap-head], &parr->data[parr->offset], sizeof(parr->data[0])*head);
+        parr->offset = cap-head;
+    }
+    //update allocated capacity
+    parr->capacity = cap;
+    return 0;
+}
+static PARRAY_INT parrayGrowth (PARRAY_INT cap, PARRAY_INT extra) {
+    //returns the capacity following given capacity according to the growth policy, but at least given number of elements more
+    //returns -1 if that exceeds PARRAY_CAPACITY_LIMIT, all math is done relative to it so that nothing can overflow
+    PARRAY_INT room = PARRAY_CAPACITY_LIMIT-cap;
+    if (extra > room) return -1;
+    double grow = cap*(PARRAY_GROWTH_FACTOR-1.0);
+    PARRAY_INT inc = (cap < PARRAY_MIN_CAPACITY) ? PARRAY_MIN_CAPACITY-cap : (grow < (double)room) ? (PARRAY_INT)grow : room;
+    if ((PARRAY_MAX_GROWTH > 0)&&(inc > PARRAY_MAX_GROWTH)) inc = PARRAY_MAX_GROWTH;
+    if (inc > room) inc = room;
+    return cap+((inc < extra) ? extra : inc);
+}
+static void parrayShrink (struct parray* parr) {
+    //halves the capacity of given parray in shrink mode once it is less than a quarter full
+    if ((!(parr->mode & PARRAY_SHRINK))||(parr->length >= parr->capacity/4)) return;
+    PARRAY_INT cap = parr->capacity/2;
+    if (cap < PARRAY_MIN_CAPACITY) cap = PARRAY_MIN_CAPACITY;
+    if (cap < PARRAY_SMALL) cap = PARRAY_SMALL;
+    //failure to shrink is harmless, the memory simply isn't released
+    if (cap < parr->capacity) parrayCapacity(parr, cap);
+}
+static int parrayGrow (struct parray* parr, PARRAY_INT num) {
+    //makes contiguous room for given number of elements past the end of given (unwrapped) parray, returns 0 on success
+    if (num <= parr->capacity-parr->offset-parr->length) return 0;
+    if ((parr->capacity-parr->length >= num)&&(parr->offset >= parr->length)) {
+        //make room by offset reset
+        memmove(&parr->data[0], &parr->data[parr->offset], sizeof(parr->data[0])*parr->length);
+        parr->offset = 0;
+        return 0;
+    }
+    //make room by reallocation
+    return parrayResize(parr, parrayGrowth(parr->capacity, num-(parr->capacity-parr->offset-parr->length)));
+}
+
+struct parray_hash {
+    long long base; //the index of an element is its stored position minus base, so dequeues don't touch other entries
+    int bits; //log2 of the number of slots
+    PARRAY_INT used; //number of slots that aren't empty, including deleted ones
+    PARRAY_INT count; //number of entries
+    struct parray_slot {void* ele; long long pos;} slots[]; //open addressing with linear probing
+};
+#define PARRAY_SLOT_EMPTY LLONG_MIN
+#define PARRAY_SLOT_DELETED (LLONG_MIN+1)
+static size_t parrayHashSize (int bits) {
+    return sizeof(struct parray_hash)+sizeof(struct parray_slot)*((size_t)1 << bits);
+}
+static size_t parrayHashSlot (const struct parray_hash* hash, const void* ele) {
+    //fibonacci hashing of the pointer value
+    return (size_t)(((uint64_t)(uintptr_t)ele*0x9E3779B97F4A7C15ull) >> (64-hash->bits));
+}
+static void parrayHashDrop (struct parray* parr) {
+    //frees the index and leaves index mode, after which lookups fall back to linear scans
+    if (parr->hash) parrayRealloc(parr->alloc, parr->hash, parrayHashSize(parr->hash->bits), 0);
+    parr->hash = NULL;
+    parr->mode &= ~PARRAY_INDEX;
+}
+static void parrayHashInsert (struct parray_hash* hash, void* ele, long long pos) {
+    size_t mask = ((size_t)1 << hash->bits)-1, i = parrayHashSlot(hash, ele);
+    while (hash->slots[i].pos > PARRAY_SLOT_DELETED) i = (i+1) & mask;
+    if (hash->slots[i].pos == PARRAY_SLOT_EMPTY) hash->used++;
+    hash->slots[i].ele = ele; hash->slots[i].pos = pos;
+    hash->count++;
+}
+static int parrayHashRebuild (struct parray* parr) {
+    //refills the index from scratch, reallocating it to fit the current length, returns 0 on success
+    if (!parr->hash) return 0;
+    int bits = 4;
+    while (((size_t)1 << bits) < (size_t)parr->length*2) bits++;
+    if (bits != parr->hash->bits) {
+        struct parray_hash* hash = parrayRealloc(parr->alloc, parr->hash, parrayHashSize(parr->hash->bits), parrayHashSize(bits));
+        if (!hash) {parrayHashDrop(parr); return -1;}
+        parr->hash = hash; hash->bits = bits;
+    }
+    parr->hash->base = 0; parr->hash->used = parr->hash->count = 0;
+    for (size_t i = 0; i < ((size_t)1 << bits); i++) parr->hash->slots[i].pos = PARRAY_SLOT_EMPTY;
+    for (PARRAY_INT i = 0; i < parr->length; i++) parrayHashInsert(parr->hash, parr->data[parrayAt(parr, i)], i);
+    return 0;
+}
+static void parrayHashAdd (struct parray* parr, void* ele, PARRAY_INT ind) {
+    //adds an entry for given element which is already stored at given index, growing the table once it is three quarters full
+    if (!parr->hash) return;
+    if ((size_t)(parr->hash->used+1)*4 > ((size_t)3 << parr->hash->bits)) {
+        //rebuilding from the elements themselves covers the new one too and clears out deleted slots
+        parrayHashRebuild(parr);
+        return;
+    }
+    parrayHashInsert(parr->hash, ele, ind+parr->hash->base);
+}
+static void parrayHashErase (struct parray* parr, const void* ele, PARRAY_INT ind) {
+    //deletes the entry for given element at given index
+    if (!parr->hash) return;
+    size_t mask = ((size_t)1 << parr->hash->bits)-1, i = parrayHashSlot(parr->hash, ele);
+    long long pos = ind+parr->hash->base;
+    for (; parr->hash->slots[i].pos != PARRAY_SLOT_EMPTY; i = (i+1) & mask)
+        if ((parr->hash->slots[i].ele == ele)&&(parr->hash->slots[i].pos == pos)) {
+            parr->hash->slots[i].pos = PARRAY_SLOT_DELETED;
+            parr->hash->count--;
+            return;
+        }
+}
 
 //general functions
+PADEF void parrayInit (struct parray* parr) {
+    memset(parr, 0, sizeof(struct parray));
+    //start out using the inline buffer if there is one
+    parr->data = PARRAY_SMALL_DATA(parr);
+    parr->capacity = PARRAY_SMALL;
+}
+PADEF void parrayDeinit (struct parray* parr) {
+    parrayHashDrop(parr);
+    if (parr->share) parrayRelease(parr);
+    else if (!PARRAY_IS_SMALL(parr)) parrayRealloc(parr->alloc, parr->data, sizeof(parr->data[0])*parr->capacity, 0);
+    parrayInitEx(parr, parr->alloc);
+}
+PADEF void parrayInitEx (struct parray* parr, const struct parray_allocator* alloc) {
+    parrayInit(parr);
+    parr->alloc = alloc;
+}
+PADEF struct parray* parrayNewEx (const struct parray_allocator* alloc) {
+    struct parray* parr = parrayRealloc(alloc, NULL, 0, sizeof(struct parray));
+    if (parr) parrayInitEx(parr, alloc);
+    return parr;
+}
 PADEF struct parray* parrayNew () {
-    return PARRAY_ZALLOC(sizeof(struct parray));
+    struct parray* parr = PARRAY_ZALLOC(sizeof(struct parray));
+    if (parr) parrayInit(parr);
+    return parr;
 }
-PADEF int parrayLength (const struct parray* parr) {
-    return parr->length;
+PADEF struct parray* parrayNewWithCapacity (PARRAY_INT cap) {
+    struct parray* parr = parrayNew();
+    if ((parr)&&(cap > 0)&&(parrayResize(parr, cap))) {
+        //allocation of initial capacity failed
+        parrayFree(parr);
+        return NULL;
+    }
+    return parr;
 }
-PADEF int parraySet (struct parray* parr, int ind, void* ele) {
-    if ((ind < 0)||(ind >= parr->length)) return -1;
-    parr->data[parr->offset+ind] = ele;
-    return ind;
+PADEF struct parray* parrayClone (const struct parray* parr) {
+    struct parray* copy = parrayNewEx(parr->alloc);
+    if (!copy) return NULL;
+    if ((parr->length)&&(parrayResize(copy, parr->length))) {
+        parrayFree(copy);
+        return NULL;
+    }
+    //one run unless wrapped or gapped
+    for (PARRAY_INT done = 0, run; done < parr->length; done += run) {
+        run = parrayRun(parr, done, parr->length-done);
+        memcpy(&copy->data[done], &parr->data[parrayAt(parr, done)], sizeof(parr->data[0])*run);
+    }
+    copy->length = parr->length;
+    parrayMode(copy, parr->mode);
+    return copy;
 }
-PADEF int parrayIndexOf (const struct parray* parr, void* ele) {
-    for (int i = 0; i < parr->length; i++)
-        if (parr->data[parr->offset+i] == ele) return i;
-    return -1;
+PADEF struct parray* parraySnapshot (struct parray* parr) {
+    struct parray* snap = parrayRealloc(parr->alloc, NULL, 0, sizeof(struct parray));
+    if (!snap) return NULL;
+    if ((parr->data)&&(!PARRAY_IS_SMALL(parr))&&(!parr->share)) {
+        //the buffer becomes shared starting with this first snapshot
+        if (!(parr->share = parrayRealloc(parr->alloc, NULL, 0, sizeof(struct parray_share)))) {
+            parrayRealloc(parr->alloc, snap, sizeof(struct parray), 0);
+            return NULL;
+        }
+        PARRAY_REFS_INIT(&parr->share->refs, 1);
+        parr->share->borrowed = 0; parr->share->map = NULL;
+    }
+    *snap = *parr;
+    snap->data = PARRAY_IS_SMALL(parr) ? PARRAY_SMALL_DATA(snap) : parr->data;
+    snap->hash = NULL; snap->mode &= ~PARRAY_INDEX; snap->released = 0;
+    if (snap->share) PARRAY_REFS_ADD(&snap->share->refs);
+    return snap;
 }
-PADEF void* parrayGet (const struct parray* parr, int ind) {
-    if ((ind < 0)||(ind >= parr->length)) return NULL;
-    return parr->data[parr->offset+ind];
+
+//serialization functions
+struct parray_image {
+    char magic[8]; //PARRAY_MAGIC
+    uint64_t length; //number of elements following the header
+    uint32_t order; //PARRAY_ORDER as written, to detect images of different byte order
+    uint32_t width; //size of each element in bytes, which must match that of a pointer
+    uint64_t relative; //1 if elements are offsets from a base, 0 if they are pointers
+};
+#define PARRAY_MAGIC "parray\0\1"
+#define PARRAY_ORDER 0x01020304u
+static const struct parray_image* parrayImageCheck (const void* image, size_t size) {
+    //returns the header of given image if it is valid and complete, NULL otherwise
+    const struct parray_image* head = image;
+    if ((!image)||(size < sizeof(struct parray_image))||((uintptr_t)image % sizeof(void*))) return NULL;
+    if ((memcmp(head->magic, PARRAY_MAGIC, 8))||(head->order != PARRAY_ORDER)||(head->width != sizeof(void*))) return NULL;
+    if (head->length > (uint64_t)PARRAY_CAPACITY_LIMIT) return NULL;
+    if (head->length > (size-sizeof(struct parray_image))/sizeof(void*)) return NULL;
+    return head;
 }
-PADEF void* parrayGetFirst (const struct parray* parr) {
-    if (!parr->length) return NULL;
-    return parr->data[parr->offset];
+static int parrayView (struct parray* parr, const void* image, size_t size, void* map, size_t mapsize) {
+    //sets up given parray as a view of given image, borrowing it through a share that can't be taken over
+    const struct parray_image* head = parrayImageCheck(image, size);
+    parrayInit(parr);
+    if (!head) return -1;
+    if (!head->length) return 0;
+    if (!(parr->share = parrayRealloc(NULL, NULL, 0, sizeof(struct parray_share)))) return -1;
+    PARRAY_REFS_INIT(&parr->share->refs, 1);
+    parr->share->borrowed = 1; parr->share->map = map; parr->share->size = mapsize;
+    parr->data = (void**)(uintptr_t)(head+1);
+    parr->length = parr->capacity = (PARRAY_INT)head->length;
+    return 0;
 }
-PADEF void* parrayGetLast (const struct parray* parr) {
-    if (!parr->length) return NULL;
-    return parr->data[parr->offset+parr->length-1];
+PADEF size_t parraySerialize (const struct parray* parr, const void* base, void* buf, size_t size) {
+    size_t need = sizeof(struct parray_image)+sizeof(void*)*(size_t)parr->length;
+    if ((!buf)||(size < need)) return need;
+    struct parray_image head = {PARRAY_MAGIC, (uint64_t)parr->length, PARRAY_ORDER, sizeof(void*), base ? 1 : 0};
+    memcpy(buf, &head, sizeof(head));
+    //elements are written through memcpy since given buffer needn't be aligned
+    char* out = (char*)buf+sizeof(head);
+    for (PARRAY_INT done = 0, run; done < parr->length; done += run) {
+        void* const* eles = &parr->data[parrayAt(parr, done)];
+        run = parrayRun(parr, done, parr->length-done);
+        if (!base) memcpy(out, eles, sizeof(void*)*run);
+        else for (PARRAY_INT i = 0; i < run; i++) {
+            uintptr_t off = (uintptr_t)eles[i]-(uintptr_t)base;
+            memcpy(out+sizeof(void*)*i, &off, sizeof(void*));
+        }
+        out += sizeof(void*)*run;
+    }
+    return need;
+}
+PADEF int parrayLoad (struct parray* parr, const void* image, size_t size, const void* base) {
+    const struct parray_image* head = parrayImageCheck(image, size);
+    if ((!head)||(head->relative != (base ? 1u : 0u))) return -1;
+    PARRAY_INT num = (PARRAY_INT)head->length;
+    const uintptr_t* offs = (const uintptr_t*)(head+1);
+    parrayClear(parr);
+    if (parrayCapacity(parr, num) < num) return -1;
+    parrayLinear(parr);
+    for (PARRAY_INT i = 0; i < num; i++) parr->data[i] = (void*)(offs[i]+(uintptr_t)base);
+    parr->length = num;
+    parrayHashRebuild(parr);
+    return 0;
+}
+PADEF int parrayMapImage (struct parray* parr, const void* image, size_t size) {
+    return parrayView(parr, image, size, NULL, 0);
+}
+#ifdef PARRAY_MMAP
+PADEF int parrayMapFile (struct parray* parr, const char* path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    parrayInit(parr);
+    if (fd < 0) return -1;
+    if ((fstat(fd, &st))||(st.st_size < (off_t)sizeof(struct parray_image))) {close(fd); return -1;}
+    //the mapping stays valid after closing the descriptor
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    if (parrayView(parr, map, (size_t)st.st_size, map, (size_t)st.st_size)) {munmap(map, (size_t)st.st_size); return -1;}
+    //an empty image holds nothing to borrow
+    if (!parr->share) munmap(map, (size_t)st.st_size);
+    return 0;
+}
+#endif
+PADEF PARRAY_INT parrayIndexOf (const struct parray* parr, void* ele) {
+    if (parr->hash) {
+        //the same element may be stored more than once, so all of its entries are checked for the lowest index
+        const struct parray_hash* hash = parr->hash;
+        size_t mask = ((size_t)1 << hash->bits)-1, i = parrayHashSlot(hash, ele);
+        long long min = -1;
+        for (; hash->slots[i].pos != PARRAY_SLOT_EMPTY; i = (i+1) & mask)
+            if ((hash->slots[i].ele == ele)&&(hash->slots[i].pos != PARRAY_SLOT_DELETED)&&((min < 0)||(hash->slots[i].pos-hash->base < min)))
+                min = hash->slots[i].pos-hash->base;
+        return (PARRAY_INT)min;
+    }
+    //indices before the gap are stored at the end of the ring, so those are scanned first
+    PARRAY_INT split = parr->length-parr->gap, ind;
+    if ((parr->gap)&&((ind = parrayScanRing(parr, split, parr->length, ele)) >= 0)) return ind-split;
+    ind = parrayScanRing(parr, 0, split, ele);
+    return (ind < 0) ? -1 : ind+parr->gap;
+}
+PADEF int parrayContains (const struct parray* parr, void* ele) {
+    return parrayIndexOf(parr, ele) >= 0;
+}
+PADEF void** parrayData (struct parray* parr) {
+    if (parrayWrite(parr)) return NULL;
+    parrayLinear(parr);
+    return parr->data ? &parr->data[parr->offset] : NULL;
+}
+PADEF void parrayReindex (struct parray* parr) {
+    parrayHashRebuild(parr);
 }
 PADEF void parrayClear (struct parray* parr) {
-    parr->offset = parr->length = 0;
+    if (parr->share) {
+        //nothing is left to share, so the buffer is simply let go of
+        parrayRelease(parr);
+        parr->data = PARRAY_SMALL_DATA(parr);
+        parr->capacity = PARRAY_SMALL;
+    }
+    parr->offset = parr->length = parr->gap = 0;
+    parrayHashRebuild(parr);
 }
 PADEF void parrayFree (struct parray* parr) {
-    PARRAY_FREE(parr->data); PARRAY_FREE(parr);
+    parrayDeinit(parr);
+    parrayRealloc(parr->alloc, parr, sizeof(struct parray), 0);
 }
 
 //stack-like functions
-PADEF int parrayPush (struct parray* parr, void* ele) {
-    if (!parr->capacity) {
-        //allocate initial capacity of 1 element
-        parr->data = PARRAY_REALLOC(parr->data, sizeof(parr->data[0]));
-        //check for malloc failure
-        if (!parr->data) return -1;
-        //update allocated capacity
-        parr->capacity = 1;
-    }
-    if (parr->offset+parr->length == parr->capacity)
-        if (parr->offset >= parr->length) {
-            //double the available capacity by offset reset
-            memcpy(&parr->data[0], &parr->data[parr->offset], sizeof(parr->data[0])*parr->length);
-            parr->offset = 0;
-        } else {
-            //double the available capacity by reallocation
-            void** ndat = PARRAY_REALLOC(parr->data, sizeof(parr->data[0])*(parr->capacity*2));
-            //check for realloc failure
-            if (!ndat) return -1;
-            //update allocated capacity
-            parr->capacity *= 2;
-            parr->data = ndat;
-        }
-    parr->data[parr->offset+parr->length] = ele;
-    return parr->length++;
+PADEF PARRAY_INT parrayPushSlow (struct parray* parr, void* ele) {
+    if (parrayWrite(parr)) return -1;
+    if (parr->gap) parrayGapMove(parr, parr->length);
+    if (parr->mode & (PARRAY_RING|PARRAY_GAP)) {
+        //wrap around instead of compacting, only growing when full
+        if ((parr->length == parr->capacity)&&(parrayResize(parr, parrayGrowth(parr->capacity, 1)))) return -1;
+    } else if (parrayGrow(parr, 1)) return -1;
+    parr->data[parrayAt(parr, parr->length++)] = ele;
+    parrayHashAdd(parr, ele, parr->length-1);
+    return parr->length-1;
+}
+PADEF PARRAY_INT parraySetSlow (struct parray* parr, PARRAY_INT ind, void* ele) {
+    if (parrayWrite(parr)) return -1;
+    parrayHashErase(parr, parr->data[parrayAt(parr, ind)], ind);
+    parr->data[parrayAt(parr, ind)] = ele;
+    parrayHashAdd(parr, ele, ind);
+    return ind;
 }
 PADEF void* parrayPop (struct parray* parr) {
-    if (!parr->length) return NULL;
+    if ((!parr->length)||(parrayWrite(parr))) return NULL;
+    if (parr->gap) parrayGapMove(parr, parr->length);
     parr->length--; //reduce length
-    return parr->data[parr->offset+parr->length];
+    void* ele = parr->data[parrayAt(parr, parr->length)];
+    parrayHashErase(parr, ele, parr->length);
+    parrayShrink(parr);
+    return ele;
 }
 
 //queue-like functions
 PADEF void* parrayDequeue (struct parray* parr) {
-    if (!parr->length) return NULL;
+    if ((!parr->length)||(parrayWrite(parr))) return NULL;
+    if (parr->gap) parrayGapMove(parr, 0);
     parr->length--; //reduce length
-    return parr->data[parr->offset++];
+    void* ele = parr->data[parr->offset++];
+    if (parr->offset == parr->capacity) parr->offset = 0;
+    if (parr->hash) {
+        //shifting the base moves every remaining entry down by one index at once
+        parrayHashErase(parr, ele, 0);
+        parr->hash->base++;
+    }
+    parrayShrink(parr);
+    return ele;
+}
+static void parrayAdvance (struct parray* parr, PARRAY_INT num) {
+    //drops given number of elements from the front with a single offset update
+    if (parr->hash) {
+        for (PARRAY_INT i = 0; i < num; i++) parrayHashErase(parr, parr->data[parrayAt(parr, i)], i);
+        parr->hash->base += num;
+    }
+    parr->offset = parrayAt(parr, num);
+    parr->length -= num;
+}
+PADEF PARRAY_INT parrayDequeueN (struct parray* parr, void** out, PARRAY_INT max) {
+    if (max < 0) return -1;
+    PARRAY_INT num = (max < parr->length) ? max : parr->length;
+    if (!num) return 0;
+    if (parrayWrite(parr)) return -1;
+    if (parr->gap) parrayGapMove(parr, 0);
+    //copy the part before the end of the buffer, then whatever wrapped around to its start
+    PARRAY_INT head = (num > parr->capacity-parr->offset) ? parr->capacity-parr->offset : num;
+    memcpy(out, &parr->data[parr->offset], sizeof(parr->data[0])*head);
+    memcpy(&out[head], parr->data, sizeof(parr->data[0])*(num-head));
+    parrayAdvance(parr, num);
+    parrayShrink(parr);
+    return num;
+}
+PADEF void** parrayDrain (struct parray* parr, PARRAY_INT* num) {
+    *num = 0;
+    if (parrayWrite(parr)) return NULL;
+    if (parr->gap) parrayGapMove(parr, 0);
+    *num = (parr->length > parr->capacity-parr->offset) ? parr->capacity-parr->offset : parr->length;
+    if (!*num) return NULL;
+    void** run = &parr->data[parr->offset];
+    //no shrinking here, since that could free the run before the caller gets to it
+    parrayAdvance(parr, *num);
+    return run;
 }
 
 //sort/search functions
-PADEF int parrayFindIndex (const struct parray* parr, int(*comp)(const void*, const void**), const void* key) {
-    void** res = bsearch(key, &parr->data[parr->offset], parr->length, sizeof(parr->data[0]), (int(*)(const void*, const void*))comp);
+PADEF PARRAY_INT parrayFindIndex (const struct parray* parr, int(*comp)(const void*, const void**), const void* key) {
+    if (!parr->length) return -1; //nothing to search
+    if (parr->gap) {
+        //the segments on either side of the gap don't line up with those in data, so search by index instead
+        PARRAY_INT ind = parrayLowerBound(parr, comp, key);
+        return ((ind < parr->length)&&(!comp(key, (const void**)&parr->data[parrayAt(parr, ind)]))) ? ind : -1;
+    }
+    //a wrapped ring is searched as two separately sorted segments
+    PARRAY_INT head = (parr->length > parr->capacity-parr->offset) ? parr->capacity-parr->offset : parr->length;
+    void** res = bsearch(key, &parr->data[parr->offset], head, sizeof(parr->data[0]), (int(*)(const void*, const void*))comp);
+    if (res) return res - &parr->data[parr->offset];
+    if (head == parr->length) return -1; //element not found
+    res = bsearch(key, &parr->data[0], parr->length-head, sizeof(parr->data[0]), (int(*)(const void*, const void*))comp);
     if (!res) return -1; //element not found
-    return res - &parr->data[parr->offset];
+    return head + (res - &parr->data[0]);
+}
+PADEF void parrayFindIndexBatch (const struct parray* parr, int(*comp)(const void*, const void**), const void* const* keys, PARRAY_INT num, PARRAY_INT* out) {
+    for (PARRAY_INT first = 0; first < num; first += PARRAY_BATCH) {
+        //all searches in a group probe the same depth at the same time, so each prefetch has a full round to complete
+        PARRAY_INT base[PARRAY_BATCH], group = (num-first < PARRAY_BATCH) ? num-first : PARRAY_BATCH, len = parr->length;
+        for (PARRAY_INT g = 0; g < group; g++) base[g] = 0;
+        while (len > 1) {
+            PARRAY_INT half = len/2;
+            for (PARRAY_INT g = 0; g < group; g++) {
+                if (comp(keys[first+g], (const void**)&parr->data[parrayAt(parr, base[g]+half-1)]) > 0) base[g] += half;
+                PARRAY_PREFETCH(parr->data[parrayAt(parr, base[g]+(len-half)/2-1+((len-half)/2 == 0))]);
+            }
+            len -= half;
+        }
+        for (PARRAY_INT g = 0; g < group; g++) {
+            //finish with the lower bound, which is either the last probe or the element right after it
+            PARRAY_INT ind = base[g];
+            if ((len)&&(comp(keys[first+g], (const void**)&parr->data[parrayAt(parr, ind)]) > 0)) ind++;
+            out[first+g] = ((ind < parr->length)&&(!comp(keys[first+g], (const void**)&parr->data[parrayAt(parr, ind)]))) ? ind : -1;
+        }
+    }
 }
 PADEF void* parrayFindElement (const struct parray* parr, int(*comp)(const void*, const void**), const void* key) {
-    void** res = bsearch(key, &parr->data[parr->offset], parr->length, sizeof(parr->data[0]), (int(*)(const void*, const void*))comp);
-    if (!res) return NULL; //element not found
-    return *res;
+    PARRAY_INT ind = parrayFindIndex(parr, comp, key);
+    if (ind < 0) return NULL; //element not found
+    return parr->data[parrayAt(parr, ind)];
+}
+PADEF PARRAY_INT parrayLowerBound (const struct parray* parr, int(*comp)(const void*, const void**), const void* key) {
+    PARRAY_INT lo = 0, hi = parr->length;
+    while (lo < hi) {
+        PARRAY_INT mid = lo+(hi-lo)/2;
+        if (comp(key, (const void**)&parr->data[parrayAt(parr, mid)]) > 0) lo = mid+1;
+        else hi = mid;
+    }
+    return lo;
+}
+PADEF PARRAY_INT parrayUpperBound (const struct parray* parr, int(*comp)(const void*, const void**), const void* key) {
+    PARRAY_INT lo = 0, hi = parr->length;
+    while (lo < hi) {
+        PARRAY_INT mid = lo+(hi-lo)/2;
+        if (comp(key, (const void**)&parr->data[parrayAt(parr, mid)]) >= 0) lo = mid+1;
+        else hi = mid;
+    }
+    return lo;
+}
+PADEF PARRAY_INT parraySortedInsert (struct parray* parr, int(*comp)(const void**, const void**), void* ele) {
+    PARRAY_INT lo = 0, hi = parr->length;
+    while (lo < hi) {
+        PARRAY_INT mid = lo+(hi-lo)/2;
+        if (comp((const void**)&ele, (const void**)&parr->data[parrayAt(parr, mid)]) >= 0) lo = mid+1;
+        else hi = mid;
+    }
+    return parrayInsertN(parr, lo, &ele, 1);
+}
+PADEF void* parraySortedRemove (struct parray* parr, int(*comp)(const void*, const void**), const void* key) {
+    PARRAY_INT ind = parrayLowerBound(parr, comp, key);
+    if ((ind == parr->length)||(comp(key, (const void**)&parr->data[parrayAt(parr, ind)]))) return NULL;
+    return parrayRemove(parr, ind);
 }
 PADEF void parraySortInsert (struct parray* parr, int(*comp)(const void**, const void**)) {
-    for (int j = 1; j < parr->length; j++)
-        for (int i = parr->offset+j; (i > parr->offset)&&(comp((const void**)&parr->data[i-1], (const void**)&parr->data[i]) > 0); i--) {
+    if (parrayWrite(parr)) return;
+    parrayLinear(parr);
+    for (PARRAY_INT j = 1; j < parr->length; j++)
+        for (PARRAY_INT i = parr->offset+j; (i > parr->offset)&&(comp((const void**)&parr->data[i-1], (const void**)&parr->data[i]) > 0); i--) {
             void* temp = parr->data[i];
             parr->data[i] = parr->data[i-1];
             parr->data[i-1] = temp;
         }
+    parrayHashRebuild(parr);
 }
+typedef int(*parray_comp)(const void**, const void**);
+#define PARRAY_LESS_COMP(A, B) (ctx((const void**)&(A), (const void**)&(B)) < 0)
+PARRAY_SORT_ENGINE(void, parraySortEngine, PARRAY_LESS_COMP, parray_comp)
 PADEF void parraySortStandard (struct parray* parr, int(*comp)(const void**, const void**)) {
-    qsort(&parr->data[parr->offset], parr->length, sizeof(parr->data[0]), (int(*)(const void*, const void*))comp);
+    if (parrayWrite(parr)) return;
+    parraySortEngine(parrayData(parr), parr->length, comp);
+    parrayHashRebuild(parr);
+}
+
+struct parray_sortjob {
+    void** src; void** dst;
+    PARRAY_INT num;
+    int chunks, width;
+    parray_comp comp;
+};
+static PARRAY_INT parraySortBound (const struct parray_sortjob* job, int chunk) {
+    //returns the index at which given chunk starts
+    if (chunk > job->chunks) chunk = job->chunks;
+    //split up so that the multiplication can't overflow
+    return job->num/job->chunks*chunk+job->num%job->chunks*chunk/job->chunks;
+}
+static void parraySortChunk (void* ctx, int ind) {
+    struct parray_sortjob* job = ctx;
+    PARRAY_INT lo = parraySortBound(job, ind);
+    parraySortEngine(&job->src[lo], parraySortBound(job, ind+1)-lo, job->comp);
+}
+static void parraySortMerge (void* ctx, int ind) {
+    //merges two neighbouring runs of width chunks each from src into dst, taking from the left on ties
+    struct parray_sortjob* job = ctx;
+    PARRAY_INT i = parraySortBound(job, ind*2*job->width), end = parraySortBound(job, (ind*2+2)*job->width);
+    PARRAY_INT mid = parraySortBound(job, (ind*2+1)*job->width), j = mid, k = i;
+    while ((i < mid)&&(j < end))
+        job->dst[k++] = (job->comp((const void**)&job->src[j], (const void**)&job->src[i]) < 0) ? job->src[j++] : job->src[i++];
+    memcpy(&job->dst[k], &job->src[i], sizeof(job->src[0])*(mid-i)); k += mid-i;
+    memcpy(&job->dst[k], &job->src[j], sizeof(job->src[0])*(end-j));
+}
+PADEF int parraySortParallel (struct parray* parr, int(*comp)(const void**, const void**), const struct parray_executor* exec) {
+    if ((!exec)||(exec->threads < 2)||(parr->length < PARRAY_PARALLEL_MIN)) {
+        //not worth the overhead
+        parraySortStandard(parr, comp);
+        return 0;
+    }
+    if (parrayWrite(parr)) return -1;
+    struct parray_sortjob job = {parrayData(parr), NULL, parr->length, exec->threads, 1, comp};
+    if (!(job.dst = parrayRealloc(parr->alloc, NULL, 0, sizeof(parr->data[0])*parr->length))) return -1;
+    void** temp = job.dst;
+    exec->run(exec, parraySortChunk, &job, job.chunks);
+    for (; job.width < job.chunks; job.width *= 2) {
+        //each round halves the number of runs, alternating between the parray and the temporary buffer
+        exec->run(exec, parraySortMerge, &job, (job.chunks+job.width*2-1)/(job.width*2));
+        void** swap = job.src; job.src = job.dst; job.dst = swap;
+    }
+    if (job.src == temp) memcpy(job.dst, job.src, sizeof(parr->data[0])*parr->length);
+    parrayRealloc(parr->alloc, temp, sizeof(parr->data[0])*parr->length, 0);
+    parrayHashRebuild(parr);
+    return 0;
+}
+PADEF int parraySortByKey (struct parray* parr, uint64_t(*key)(const void*)) {
+    //lsd radix sort over (key, element) pairs, one byte per pass
+    struct parray_keyed {uint64_t key; void* ele;} *src, *dst, *temp;
+    size_t count[8][256] = {{0}}, size = sizeof(struct parray_keyed)*parr->length*2;
+    if (parrayWrite(parr)) return -1;
+    void** data = parrayData(parr);
+    if (parr->length < 2) return 0;
+    if ((size_t)parr->length > SIZE_MAX/(sizeof(struct parray_keyed)*2)) return -1; //size above overflowed
+    if (!(src = parrayRealloc(parr->alloc, NULL, 0, size))) return -1;
+    dst = src+parr->length;
+    //extract keys and count byte occurrences for all passes at once
+    for (PARRAY_INT i = 0; i < parr->length; i++) {
+        src[i].key = key(data[i]); src[i].ele = data[i];
+        for (int b = 0; b < 8; b++) count[b][(src[i].key >> b*8) & 255]++;
+    }
+    for (int b = 0; b < 8; b++) {
+        //skip passes in which all keys share the same byte
+        if (count[b][(src[0].key >> b*8) & 255] == (size_t)parr->length) continue;
+        for (size_t j = 0, sum = 0, c; j < 256; j++) {c = count[b][j]; count[b][j] = sum; sum += c;}
+        for (PARRAY_INT i = 0; i < parr->length; i++) dst[count[b][(src[i].key >> b*8) & 255]++] = src[i];
+        temp = src; src = dst; dst = temp;
+    }
+    for (PARRAY_INT i = 0; i < parr->length; i++) data[i] = src[i].ele;
+    //the buffer starts at whichever of the two halves is lower
+    parrayRealloc(parr->alloc, (src < dst) ? src : dst, size, 0);
+    parrayHashRebuild(parr);
+    return 0;
+}
+
+//lookup functions
+struct parray_lookup {
+    const struct parray_allocator* alloc;
+    void* block; //allocation holding the struct as well as both arrays
+    size_t size; //size of the allocation
+    PARRAY_INT length; //number of keys
+    PARRAY_INT* index; //original index of each key, in the same order as keys
+    uint64_t* keys; //keys in eytzinger order starting at 1, aligned to a cache line
+};
+static PARRAY_INT parrayLookupBuild (struct parray_lookup* look, const struct parray* parr, uint64_t(*key)(const void*), PARRAY_INT node, PARRAY_INT ind) {
+    //fills the subtree below given node by in-order traversal, returns the next unused sorted index
+    if (node > look->length) return ind;
+    ind = parrayLookupBuild(look, parr, key, node*2, ind);
+    look->keys[node] = key(parr->data[parrayAt(parr, ind)]);
+    look->index[node] = ind;
+    return parrayLookupBuild(look, parr, key, node*2+1, ind+1);
+}
+PADEF struct parray_lookup* parrayLookupNew (const struct parray* parr, uint64_t(*key)(const void*)) {
+    if ((size_t)parr->length >= (SIZE_MAX-sizeof(struct parray_lookup)-64)/(sizeof(uint64_t)+sizeof(PARRAY_INT))) return NULL;
+    size_t size = sizeof(struct parray_lookup)+(sizeof(uint64_t)+sizeof(PARRAY_INT))*(parr->length+1)+64;
+    char* block = parrayRealloc(parr->alloc, NULL, 0, size);
+    if (!block) return NULL;
+    struct parray_lookup* look = (struct parray_lookup*)block;
+    look->alloc = parr->alloc; look->block = block; look->size = size;
+    look->length = parr->length;
+    look->keys = (uint64_t*)((uintptr_t)(block+sizeof(struct parray_lookup)+63) & ~(uintptr_t)63);
+    look->index = (PARRAY_INT*)(look->keys+parr->length+1);
+    parrayLookupBuild(look, parr, key, 1, 0);
+    return look;
+}
+static PARRAY_INT parrayLookupNode (const struct parray_lookup* look, uint64_t key) {
+    //returns the node holding the first key not smaller than given key, or 0 if there is none
+    const uint64_t* keys = look->keys; PARRAY_INT node = 1;
+    while (node <= look->length) {
+        //descend without branching on the comparison, prefetching the nodes four levels down
+        PARRAY_PREFETCH(&keys[node*16]);
+        node = node*2+(keys[node] < key);
+    }
+    //undo the right turns taken after the last left turn, which leads back to the lower bound
+    while (node & 1) node >>= 1;
+    return node >> 1;
+}
+PADEF PARRAY_INT parrayLookupLowerBound (const struct parray_lookup* look, uint64_t key) {
+    PARRAY_INT node = parrayLookupNode(look, key);
+    return node ? look->index[node] : look->length;
+}
+PADEF PARRAY_INT parrayLookupFind (const struct parray_lookup* look, uint64_t key) {
+    PARRAY_INT node = parrayLookupNode(look, key);
+    return (node)&&(look->keys[node] == key) ? look->index[node] : -1;
+}
+PADEF void parrayLookupFree (struct parray_lookup* look) {
+    parrayRealloc(look->alloc, look->block, look->size, 0);
 }
 
 //insert/remove functions
-PADEF int parrayInsert (struct parray* parr, int ind, void* ele) {
-    if ((ind < 0)||(ind >= parr->length)) return -1;
-    if (parr->offset+parr->length == parr->capacity)
-        if (parr->offset >= parr->length) {
-            //double the available capacity by offset reset
-            memcpy(&parr->data[0], &parr->data[parr->offset], sizeof(parr->data[0])*parr->length);
-            parr->offset = 0;
-        } else {
-            //double the available capacity by reallocation
-            void** ndat = PARRAY_REALLOC(parr->data, sizeof(parr->data[0])*(parr->capacity*2));
-            //check for realloc failure
-            if (!ndat) return -1;
-            //update allocated capacity
-            parr->capacity *= 2;
-            parr->data = ndat;
-        }
+PADEF PARRAY_INT parrayInsert (struct parray* parr, PARRAY_INT ind, void* ele) {
+    if ((ind < 0)||(ind >= parr->length)||(parrayWrite(parr))) return -1;
+    if (parr->mode & PARRAY_GAP) {
+        //with the gap moved in front of the index, the new element is simply appended to the ring
+        parrayGapMove(parr, ind);
+        if ((parr->length == parr->capacity)&&(parrayResize(parr, parrayGrowth(parr->capacity, 1)))) return -1;
+        parr->data[parrayRingAt(parr, parr->length++)] = ele;
+        parr->gap = ind+1;
+        parrayHashRebuild(parr);
+        return ind;
+    }
+    parrayUnwrap(parr);
+    if (parrayGrow(parr, 1)) return -1;
     memmove(&parr->data[parr->offset+ind+1], &parr->data[parr->offset+ind], sizeof(parr->data[0])*(parr->length-ind));
     parr->data[parr->offset+ind] = ele; parr->length++;
+    parrayHashRebuild(parr);
     return ind;
 }
-PADEF void* parrayRemove (struct parray* parr, int ind) {
-    if ((ind < 0)||(ind >= parr->length)) return NULL;
+PADEF void* parrayRemove (struct parray* parr, PARRAY_INT ind) {
+    if ((ind < 0)||(ind >= parr->length)||(parrayWrite(parr))) return NULL;
+    if (parr->mode & PARRAY_GAP) {
+        //with the gap moved in front of the index, the element is simply dequeued from the ring
+        parrayGapMove(parr, ind);
+        void* ele = parr->data[parr->offset]; parr->length--;
+        if (++parr->offset == parr->capacity) parr->offset = 0;
+        if (parr->gap == parr->length) parr->gap = 0;
+        parrayHashRebuild(parr);
+        parrayShrink(parr);
+        return ele;
+    }
+    parrayUnwrap(parr);
     void* ele = parr->data[parr->offset+ind]; parr->length--;
     memmove(&parr->data[parr->offset+ind], &parr->data[parr->offset+ind+1], sizeof(parr->data[0])*(parr->length-ind));
+    parrayHashRebuild(parr);
+    parrayShrink(parr);
     return ele;
 }
-PADEF void* parrayDitch (struct parray* parr, int ind) {
+PADEF void* parrayDitch (struct parray* parr, PARRAY_INT ind) {
     if ((ind < 0)||(ind >= parr->length)) return NULL;
-    void* ele = parr->data[parr->offset+ind]; parr->data[parr->offset+ind] = parrayPop(parr);
+    PARRAY_INT len = parr->length;
+    void* ele = parr->data[parrayAt(parr, ind)]; void* last = parrayPop(parr);
+    if (parr->length == len) return NULL; //unsharing the buffer failed
+    if (ind < parr->length) parraySet(parr, ind, last);
     return ele;
 }
+PADEF PARRAY_INT parrayRemoveIf (struct parray* parr, int(*pred)(void*, void*), void* ctx) {
+    //kept elements are moved down over removed ones as they are found, which works on a wrapped ring as well
+    PARRAY_INT kept = 0;
+    if (parrayWrite(parr)) return -1;
+    if (parr->gap) parrayGapMove(parr, 0);
+    for (PARRAY_INT i = 0; i < parr->length; i++) {
+        void* ele = parr->data[parrayAt(parr, i)];
+        if (!pred(ele, ctx)) parr->data[parrayAt(parr, kept++)] = ele;
+    }
+    PARRAY_INT num = parr->length-kept;
+    parr->length = kept;
+    if (num) {
+        parrayHashRebuild(parr);
+        parrayShrink(parr);
+    }
+    return num;
+}
+PADEF PARRAY_INT parrayDitchIf (struct parray* parr, int(*pred)(void*, void*), void* ctx) {
+    //the element moved into a hole hasn't been tested yet, so the same index is tested again
+    PARRAY_INT len = parr->length;
+    if (parrayWrite(parr)) return -1;
+    if (parr->gap) parrayGapMove(parr, 0);
+    for (PARRAY_INT i = 0; i < len;) {
+        if (pred(parr->data[parrayAt(parr, i)], ctx)) parr->data[parrayAt(parr, i)] = parr->data[parrayAt(parr, --len)];
+        else i++;
+    }
+    PARRAY_INT num = parr->length-len;
+    parr->length = len;
+    if (num) {
+        parrayHashRebuild(parr);
+        parrayShrink(parr);
+    }
+    return num;
+}
 
 //memory-related functions
-PADEF int parrayCapacity (struct parray* parr, int cap) {
+PADEF PARRAY_INT parrayCapacity (struct parray* parr, PARRAY_INT cap) {
     if (cap < parr->length) cap = parr->length;
+    if (parrayWrite(parr)) return -1;
+    parrayUnwrap(parr);
     if (parr->offset) {
         memmove(&parr->data[0], &parr->data[parr->offset], sizeof(parr->data[0])*parr->length);
         parr->offset = 0;
     }
-    if (cap != parr->capacity) {
-        //adjust available capacity by reallocation
-        void** ndat = PARRAY_REALLOC(parr->data, sizeof(parr->data[0])*cap);
-        //check for realloc failure
-        if (!ndat) return -1;
-        //update allocated capacity
-        parr->capacity = cap;
-        parr->data = ndat;
-    }
+    //adjust available capacity by reallocation
+    if ((cap != parr->capacity)&&(parrayResize(parr, cap))) return -1;
     return parr->capacity;
 }
+
+//bulk functions
+PADEF PARRAY_INT parrayPushN (struct parray* parr, void** eles, PARRAY_INT num) {
+    if (num <= 0) return num ? -1 : parr->length;
+    if (parrayWrite(parr)) return -1;
+    parrayLinear(parr);
+    if (parrayGrow(parr, num)) return -1;
+    memcpy(&parr->data[parr->offset+parr->length], eles, sizeof(parr->data[0])*num);
+    if (!parr->hash) parr->length += num;
+    //elements are counted in one at a time, so a rebuild triggered by an add only covers the ones added so far
+    else for (PARRAY_INT i = 0; i < num; i++) parr->length++, parrayHashAdd(parr, eles[i], parr->length-1);
+    return parr->length-num;
+}
+PADEF PARRAY_INT parrayInsertN (struct parray* parr, PARRAY_INT ind, void** eles, PARRAY_INT num) {
+    if ((ind < 0)||(ind > parr->length)||(num < 0)) return -1;
+    if (!num) return ind;
+    if (parrayWrite(parr)) return -1;
+    parrayLinear(parr);
+    if (parrayGrow(parr, num)) return -1;
+    memmove(&parr->data[parr->offset+ind+num], &parr->data[parr->offset+ind], sizeof(parr->data[0])*(parr->length-ind));
+    memcpy(&parr->data[parr->offset+ind], eles, sizeof(parr->data[0])*num); parr->length += num;
+    parrayHashRebuild(parr);
+    return ind;
+}
+PADEF PARRAY_INT parrayRemoveRange (struct parray* parr, PARRAY_INT ind, void** out, PARRAY_INT num) {
+    if ((ind < 0)||(num < 0)||(num > parr->length-ind)) return -1;
+    if (!num) return 0;
+    if (parrayWrite(parr)) return -1;
+    parrayLinear(parr);
+    if (out) memcpy(out, &parr->data[parr->offset+ind], sizeof(parr->data[0])*num);
+    parr->length -= num;
+    memmove(&parr->data[parr->offset+ind], &parr->data[parr->offset+ind+num], sizeof(parr->data[0])*(parr->length-ind));
+    parrayHashRebuild(parr);
+    parrayShrink(parr);
+    return num;
+}
+PADEF PARRAY_INT parrayPushFront (struct parray* parr, void* ele) {
+    if (parrayWrite(parr)) return -1;
+    if (parr->gap) parrayGapMove(parr, 0);
+    if (parr->mode & (PARRAY_RING|PARRAY_GAP)) {
+        //wrap the head backwards, only growing when full
+        if ((parr->length == parr->capacity)&&(parrayResize(parr, parrayGrowth(parr->capacity, 1)))) return -1;
+        parr->offset = parr->offset ? parr->offset-1 : parr->capacity-1;
+    } else if (parr->offset) {
+        //reuse space left behind by dequeues
+        parr->offset--;
+    } else {
+        return parrayInsertN(parr, 0, &ele, 1);
+    }
+    parr->data[parr->offset] = ele; parr->length++;
+    if (parr->hash) {
+        //the new head takes the position just below the old one
+        parr->hash->base--;
+        parrayHashAdd(parr, ele, 0);
+    }
+    return 0;
+}
+
+//iteration functions
+PADEF void parrayForEach (const struct parray* parr, void(*fn)(void*, void*), void* ctx) {
+    parrayForEachRange(parr, 0, parr->length, fn, ctx);
+}
+PADEF PARRAY_INT parrayForEachRange (const struct parray* parr, PARRAY_INT ind, PARRAY_INT num, void(*fn)(void*, void*), void* ctx) {
+    if ((ind < 0)||(num < 0)||(num > parr->length-ind)) return -1;
+    for (PARRAY_INT done = 0, run; done < num; done += run) {
+        //each contiguous run is walked directly, starting with a burst of prefetches to get ahead
+        void* const* eles = &parr->data[parrayAt(parr, ind+done)];
+        PARRAY_INT i = 0;
+        run = parrayRun(parr, ind+done, num-done);
+        for (; (i < run)&&(i < PARRAY_PREFETCH_DISTANCE); i++) PARRAY_PREFETCH(eles[i]);
+        for (i = 0; i+PARRAY_PREFETCH_DISTANCE < run; i++) {
+            PARRAY_PREFETCH(eles[i+PARRAY_PREFETCH_DISTANCE]);
+            fn(eles[i], ctx);
+        }
+        for (; i < run; i++) fn(eles[i], ctx);
+    }
+    return num;
+}
+PADEF int parrayForEachBatch (const struct parray* parr, PARRAY_INT batch, void(*fn)(void* const*, PARRAY_INT, void*), void* ctx) {
+    if (batch < 1) return -1;
+    //batches never span a wrap or the gap, so the one after the current one is found before calling fn
+    PARRAY_INT ind = 0, len = parr->length ? parrayRun(parr, 0, (parr->length < batch) ? parr->length : batch) : 0;
+    for (PARRAY_INT i = 0; i < len; i++) PARRAY_PREFETCH(parr->data[parrayAt(parr, 0)+i]);
+    while (len) {
+        void* const* eles = &parr->data[parrayAt(parr, ind)];
+        PARRAY_INT next = ind+len, left = parr->length-next;
+        PARRAY_INT nlen = left ? parrayRun(parr, next, (left < batch) ? left : batch) : 0;
+        if (nlen) for (PARRAY_INT i = 0, pos = parrayAt(parr, next); i < nlen; i++) PARRAY_PREFETCH(parr->data[pos+i]);
+        fn(eles, len, ctx);
+        ind = next; len = nlen;
+    }
+    return 0;
+}
+
+struct parray_eachjob {
+    const struct parray* parr;
+    PARRAY_INT per; //elements per chunk, a multiple of a cache line
+    PARRAY_INT skew; //elements by which the first chunk is shorter so that the others start on a cache line
+    void (*fn)(void*, void*); //for each
+    void (*fold)(void*, void*, void*); //for reduce
+    char* parts; //chunk accumulators for reduce, one cache line apart or more
+    size_t stride;
+    void* ctx;
+};
+#define PARRAY_LINE (64/sizeof(void*))
+static PARRAY_INT parrayEachBound (const struct parray_eachjob* job, int chunk) {
+    //returns the index at which given chunk starts, size_t math keeps this from overflowing
+    size_t end = (size_t)chunk*(size_t)job->per;
+    return (!chunk) ? 0 : (end-(size_t)job->skew >= (size_t)job->parr->length) ? job->parr->length : (PARRAY_INT)(end-job->skew);
+}
+static int parrayEachSplit (struct parray_eachjob* job, const struct parray_executor* exec, int flags) {
+    //sizes the chunks for given executor and returns their number
+    size_t len = job->parr->length, want = (size_t)exec->threads*((flags & PARRAY_PARALLEL_DYNAMIC) ? 16 : 1);
+    size_t per = (len+want-1)/want;
+    per = (per+PARRAY_LINE-1)/PARRAY_LINE*PARRAY_LINE;
+    job->per = (PARRAY_INT)per;
+    job->skew = (PARRAY_INT)((size_t)job->parr->offset%PARRAY_LINE);
+    return (int)((len+job->skew+per-1)/per);
+}
+static void parrayEachTask (void* ctx, int ind) {
+    struct parray_eachjob* job = ctx;
+    PARRAY_INT lo = parrayEachBound(job, ind);
+    parrayForEachRange(job->parr, lo, parrayEachBound(job, ind+1)-lo, job->fn, job->ctx);
+}
+static void parrayReduceRange (const struct parray_eachjob* job, void* acc, PARRAY_INT ind, PARRAY_INT num) {
+    //folds the given range into given accumulator run by run, prefetching the same way parrayForEachRange does
+    for (PARRAY_INT done = 0, run; done < num; done += run) {
+        void* const* eles = &job->parr->data[parrayAt(job->parr, ind+done)];
+        PARRAY_INT i = 0;
+        run = parrayRun(job->parr, ind+done, num-done);
+        for (; (i < run)&&(i < PARRAY_PREFETCH_DISTANCE); i++) PARRAY_PREFETCH(eles[i]);
+        for (i = 0; i+PARRAY_PREFETCH_DISTANCE < run; i++) {
+            PARRAY_PREFETCH(eles[i+PARRAY_PREFETCH_DISTANCE]);
+            job->fold(acc, eles[i], job->ctx);
+        }
+        for (; i < run; i++) job->fold(acc, eles[i], job->ctx);
+    }
+}
+static void parrayReduceTask (void* ctx, int ind) {
+    struct parray_eachjob* job = ctx;
+    PARRAY_INT lo = parrayEachBound(job, ind);
+    parrayReduceRange(job, job->parts+job->stride*ind, lo, parrayEachBound(job, ind+1)-lo);
+}
+PADEF void parrayParallelForEach (const struct parray* parr, void(*fn)(void*, void*), void* ctx, const struct parray_executor* exec, int flags) {
+    if ((!exec)||(exec->threads < 2)||(parr->length < PARRAY_PARALLEL_MIN)) {
+        //not worth the overhead
+        parrayForEach(parr, fn, ctx);
+        return;
+    }
+    struct parray_eachjob job = {parr, 0, 0, fn, NULL, NULL, 0, ctx};
+    int chunks = parrayEachSplit(&job, exec, flags);
+    exec->run(exec, parrayEachTask, &job, chunks);
+}
+PADEF int parrayParallelReduce (const struct parray* parr, size_t size, void* acc, void(*fold)(void*, void*, void*), void(*combine)(void*, const void*, void*), void* ctx, const struct parray_executor* exec, int flags) {
+    struct parray_eachjob job = {parr, 0, 0, NULL, fold, NULL, (size+63)/64*64, ctx};
+    if (!size) return -1;
+    if ((!exec)||(exec->threads < 2)||(parr->length < PARRAY_PARALLEL_MIN)) {
+        //not worth the overhead, fold straight into the caller's accumulator
+        parrayReduceRange(&job, acc, 0, parr->length);
+        return 0;
+    }
+    int chunks = parrayEachSplit(&job, exec, flags);
+    if ((job.stride < size)||((size_t)chunks > (SIZE_MAX-64)/job.stride)) return -1; //sizes above overflowed
+    char* block = parrayRealloc(parr->alloc, NULL, 0, job.stride*chunks+64);
+    if (!block) return -1;
+    //every accumulator gets its own cache lines so that threads don't contend for them
+    job.parts = (char*)(((uintptr_t)block+63) & ~(uintptr_t)63);
+    for (int i = 0; i < chunks; i++) memcpy(job.parts+job.stride*i, acc, size);
+    exec->run(exec, parrayReduceTask, &job, chunks);
+    for (int i = 0; i < chunks; i++) combine(acc, job.parts+job.stride*i, ctx);
+    parrayRealloc(parr->alloc, block, job.stride*chunks+64, 0);
+    return 0;
+}
+
+//mode functions
+PADEF int parrayMode (struct parray* parr, int mode) {
+    int prev = parr->mode;
+    //only closing the gap or unwrapping the ring moves elements, so only those need a buffer of its own
+    int close = (!(mode & PARRAY_GAP))&&(parr->gap);
+    int unwrap = (!(mode & (PARRAY_RING|PARRAY_GAP)))&&(parr->length > parr->capacity-parr->offset);
+    if ((close||unwrap)&&(parrayWrite(parr))) return -1;
+    if (close) parrayGapMove(parr, 0);
+    if (!(mode & (PARRAY_RING|PARRAY_GAP))) parrayUnwrap(parr);
+    parr->mode = mode;
+    if ((mode & PARRAY_INDEX)&&(!parr->hash)) {
+        //start from the smallest table and let the rebuild size it, leaving index mode if either allocation fails
+        if ((parr->hash = parrayRealloc(parr->alloc, NULL, 0, parrayHashSize(4)))) parr->hash->bits = 4;
+        if (!parr->hash) parr->mode &= ~PARRAY_INDEX;
+        parrayHashRebuild(parr);
+    } else if (!(mode & PARRAY_INDEX)) parrayHashDrop(parr);
+    parrayShrink(parr);
+    return prev;
+}
+PADEF size_t parrayReleased (const struct parray* parr) {
+    return parr->released;
+}
+
+//chunked functions
+#define PARRAY_CHUNK ((PARRAY_INT)1 << PARRAY_CHUNK_BITS)
+#define PARRAY_CHUNK_MASK (PARRAY_CHUNK-1)
+#define PARRAY_CHUNK_SIZE (sizeof(void*)*PARRAY_CHUNK)
+static void** parrayChunkSlot (const struct parray_chunked* arr, PARRAY_INT pos) {
+    //returns the address of the element at given position counted from the start of the first chunk
+    const struct parray_chunk* chunk = &arr->dir[pos >> PARRAY_CHUNK_BITS];
+    return &chunk->data[(chunk->head+pos) & PARRAY_CHUNK_MASK];
+}
+static void parrayChunkShift (struct parray_chunk* chunk, PARRAY_INT from, PARRAY_INT num, int back) {
+    //moves given number of elements starting at given slot of given chunk one slot towards its end (back) or its start
+    //the ring wraps at most once within the moved range, so this takes at most three contiguous moves
+    void** data = chunk->data;
+    if (back) while (num > 0) {
+        PARRAY_INT src = (chunk->head+from+num-1) & PARRAY_CHUNK_MASK, dst = (src+1) & PARRAY_CHUNK_MASK;
+        PARRAY_INT run = (num < src+1) ? num : src+1;
+        if (run > dst+1) run = dst+1;
+        memmove(&data[dst-run+1], &data[src-run+1], sizeof(void*)*run);
+        num -= run;
+    } else while (num > 0) {
+        PARRAY_INT src = (chunk->head+from) & PARRAY_CHUNK_MASK, dst = (src-1) & PARRAY_CHUNK_MASK;
+        PARRAY_INT run = (num < PARRAY_CHUNK-src) ? num : PARRAY_CHUNK-src;
+        if (run > PARRAY_CHUNK-dst) run = PARRAY_CHUNK-dst;
+        memmove(&data[dst], &data[src], sizeof(void*)*run);
+        from += run; num -= run;
+    }
+}
+static int parrayChunkedReserve (struct parray_chunked* arr, PARRAY_INT chunks) {
+    //allocates chunks until there are at least given number, growing the directory as needed, returns 0 on success
+    if (chunks > arr->slots) {
+        PARRAY_INT slots = (arr->slots < 4) ? 4 : arr->slots;
+        while (slots < chunks) slots = (slots > PARRAY_CAPACITY_LIMIT/2) ? PARRAY_CAPACITY_LIMIT : slots*2;
+        struct parray_chunk* dir = parrayRealloc(arr->alloc, arr->dir, sizeof(arr->dir[0])*arr->slots, sizeof(arr->dir[0])*slots);
+        if (!dir) return -1;
+        arr->dir = dir; arr->slots = slots;
+    }
+    while (arr->chunks < chunks) {
+        if (!(arr->dir[arr->chunks].data = parrayRealloc(arr->alloc, NULL, 0, PARRAY_CHUNK_SIZE))) return -1;
+        arr->dir[arr->chunks++].head = 0;
+    }
+    return 0;
+}
+PADEF void parrayChunkedInit (struct parray_chunked* arr) {
+    memset(arr, 0, sizeof(struct parray_chunked));
+}
+PADEF void parrayChunkedDeinit (struct parray_chunked* arr) {
+    for (PARRAY_INT i = 0; i < arr->chunks; i++) parrayRealloc(arr->alloc, arr->dir[i].data, PARRAY_CHUNK_SIZE, 0);
+    parrayRealloc(arr->alloc, arr->dir, sizeof(arr->dir[0])*arr->slots, 0);
+    parrayChunkedInitEx(arr, arr->alloc);
+}
+PADEF void parrayChunkedInitEx (struct parray_chunked* arr, const struct parray_allocator* alloc) {
+    parrayChunkedInit(arr);
+    arr->alloc = alloc;
+}
+PADEF struct parray_chunked* parrayChunkedNewEx (const struct parray_allocator* alloc) {
+    struct parray_chunked* arr = parrayRealloc(alloc, NULL, 0, sizeof(struct parray_chunked));
+    if (arr) parrayChunkedInitEx(arr, alloc);
+    return arr;
+}
+PADEF struct parray_chunked* parrayChunkedNew () {
+    return parrayChunkedNewEx(NULL);
+}
+PADEF void* parrayChunkedGetFirst (const struct parray_chunked* arr) {
+    return parrayChunkedGet(arr, 0);
+}
+PADEF void* parrayChunkedGetLast (const struct parray_chunked* arr) {
+    return parrayChunkedGet(arr, arr->length-1);
+}
+PADEF void** parrayChunkedAddress (struct parray_chunked* arr, PARRAY_INT ind) {
+    if ((ind < 0)||(ind >= arr->length)) return NULL;
+    return parrayChunkSlot(arr, arr->offset+ind);
+}
+PADEF PARRAY_INT parrayChunkedIndexOf (const struct parray_chunked* arr, void* ele) {
+    //each chunk is scanned as up to two contiguous ranges, split where its ring wraps
+    for (PARRAY_INT c = 0, ind = -arr->offset; ind < arr->length; c++, ind += PARRAY_CHUNK) {
+        PARRAY_INT lo = (ind < 0) ? -ind : 0, hi = (arr->length-ind < PARRAY_CHUNK) ? arr->length-ind : PARRAY_CHUNK;
+        while (lo < hi) {
+            PARRAY_INT slot = (arr->dir[c].head+lo) & PARRAY_CHUNK_MASK;
+            PARRAY_INT run = (hi-lo < PARRAY_CHUNK-slot) ? hi-lo : PARRAY_CHUNK-slot;
+            PARRAY_INT res = parrayScan(&arr->dir[c].data[slot], run, ele);
+            if (res >= 0) return ind+lo+res;
+            lo += run;
+        }
+    }
+    return -1;
+}
+PADEF void parrayChunkedClear (struct parray_chunked* arr) {
+    arr->offset = arr->length = 0;
+}
+PADEF void parrayChunkedFree (struct parray_chunked* arr) {
+    parrayChunkedDeinit(arr);
+    parrayRealloc(arr->alloc, arr, sizeof(struct parray_chunked), 0);
+}
+PADEF PARRAY_INT parrayChunkedPush (struct parray_chunked* arr, void* ele) {
+    if (arr->length > PARRAY_INT_MAX-2*PARRAY_CHUNK) return -1; //keeps offset+length and the chunk count in range
+    PARRAY_INT pos = arr->offset+arr->length;
+    if (((pos >> PARRAY_CHUNK_BITS) >= arr->chunks)&&(parrayChunkedReserve(arr, (pos >> PARRAY_CHUNK_BITS)+1))) return -1;
+    *parrayChunkSlot(arr, pos) = ele;
+    return arr->length++;
+}
+PADEF void* parrayChunkedPop (struct parray_chunked* arr) {
+    if (!arr->length) return NULL;
+    return *parrayChunkSlot(arr, arr->offset+(--arr->length));
+}
+PADEF void* parrayChunkedDequeue (struct parray_chunked* arr) {
+    if (!arr->length) return NULL;
+    void* ele = *parrayChunkSlot(arr, arr->offset++);
+    if (!--arr->length) arr->offset = 0;
+    if (arr->offset == PARRAY_CHUNK) {
+        //the emptied first chunk is rotated to the end for reuse, which moves chunk pointers but no elements
+        struct parray_chunk first = arr->dir[0];
+        memmove(&arr->dir[0], &arr->dir[1], sizeof(arr->dir[0])*(arr->chunks-1));
+        arr->dir[arr->chunks-1] = first;
+        arr->offset = 0;
+    }
+    return ele;
+}
+PADEF PARRAY_INT parrayChunkedInsert (struct parray_chunked* arr, PARRAY_INT ind, void* ele) {
+    if ((ind < 0)||(ind >= arr->length)) return -1;
+    //make room at the end first, then turn each following chunk back by one slot, carrying in the last element before it
+    if (parrayChunkedPush(arr, NULL) < 0) return -1;
+    PARRAY_INT pos = arr->offset+ind, end = arr->offset+arr->length-1;
+    PARRAY_INT first = pos >> PARRAY_CHUNK_BITS, last = end >> PARRAY_CHUNK_BITS;
+    for (PARRAY_INT c = last; c > first; c--) {
+        arr->dir[c].head = (arr->dir[c].head-1) & PARRAY_CHUNK_MASK;
+        arr->dir[c].data[arr->dir[c].head] = *parrayChunkSlot(arr, (c << PARRAY_CHUNK_BITS)-1);
+    }
+    PARRAY_INT slot = pos & PARRAY_CHUNK_MASK, stop = (first == last) ? end & PARRAY_CHUNK_MASK : PARRAY_CHUNK_MASK;
+    parrayChunkShift(&arr->dir[first], slot, stop-slot, 1);
+    *parrayChunkSlot(arr, pos) = ele;
+    return ind;
+}
+PADEF void* parrayChunkedRemove (struct parray_chunked* arr, PARRAY_INT ind) {
+    if ((ind < 0)||(ind >= arr->length)) return NULL;
+    //close the gap within its chunk, then carry the first element of each following chunk back and turn it by one slot
+    PARRAY_INT pos = arr->offset+ind, end = arr->offset+arr->length-1;
+    PARRAY_INT first = pos >> PARRAY_CHUNK_BITS, last = end >> PARRAY_CHUNK_BITS;
+    PARRAY_INT slot = pos & PARRAY_CHUNK_MASK, stop = (first == last) ? end & PARRAY_CHUNK_MASK : PARRAY_CHUNK_MASK;
+    void* ele = *parrayChunkSlot(arr, pos);
+    parrayChunkShift(&arr->dir[first], slot+1, stop-slot, 0);
+    for (PARRAY_INT c = first+1; c <= last; c++) {
+        *parrayChunkSlot(arr, (c << PARRAY_CHUNK_BITS)-1) = arr->dir[c].data[arr->dir[c].head];
+        arr->dir[c].head = (arr->dir[c].head+1) & PARRAY_CHUNK_MASK;
+    }
+    if (!--arr->length) arr->offset = 0;
+    return ele;
+}
+PADEF void* parrayChunkedDitch (struct parray_chunked* arr, PARRAY_INT ind) {
+    if ((ind < 0)||(ind >= arr->length)) return NULL;
+    void* ele = parrayChunkedGet(arr, ind); void* last = parrayChunkedPop(arr);
+    if (ind < arr->length) parrayChunkedSet(arr, ind, last);
+    return ele;
+}
+PADEF PARRAY_INT parrayChunkedCapacity (struct parray_chunked* arr, PARRAY_INT cap) {
+    if (cap < arr->length) cap = arr->length;
+    if (cap > PARRAY_INT_MAX-2*PARRAY_CHUNK) return -1;
+    PARRAY_INT chunks = (arr->offset+cap+PARRAY_CHUNK_MASK) >> PARRAY_CHUNK_BITS;
+    if (parrayChunkedReserve(arr, chunks)) return -1;
+    //free unused chunks past the requested capacity, the directory itself is kept
+    while (arr->chunks > chunks) parrayRealloc(arr->alloc, arr->dir[--arr->chunks].data, PARRAY_CHUNK_SIZE, 0);
+    return arr->chunks*PARRAY_CHUNK-arr->offset;
+}
+
+//value functions
+static char* parrayValueAt (const struct parray_value* arr, PARRAY_INT ind) {
+    //returns the address of the element at given index
+    return arr->data+arr->size*(size_t)(arr->offset+ind);
+}
+static int parrayValueResize (struct parray_value* arr, PARRAY_INT cap) {
+    //reallocates the buffer of given value parray to given capacity, which must hold all elements past offset
+    if ((cap < 0)||((size_t)cap > SIZE_MAX/arr->size)) return -1;
+    char* data = parrayRealloc(arr->alloc, arr->data, arr->size*arr->capacity, arr->size*cap);
+    if ((!data)&&(cap)) return -1;
+    arr->data = data; arr->capacity = cap;
+    return 0;
+}
+static int parrayValueGrow (struct parray_value* arr, PARRAY_INT num) {
+    //makes room for given number of elements past the end the same way parrayGrow does, returns 0 on success
+    if (num <= arr->capacity-arr->offset-arr->length) return 0;
+    if ((arr->capacity-arr->length >= num)&&(arr->offset >= arr->length)) {
+        //make room by offset reset
+        memmove(arr->data, parrayValueAt(arr, 0), arr->size*arr->length);
+        arr->offset = 0;
+        return 0;
+    }
+    //make room by reallocation
+    return parrayValueResize(arr, parrayGrowth(arr->capacity, num-(arr->capacity-arr->offset-arr->length)));
+}
+PADEF void parrayValueInit (struct parray_value* arr, size_t size) {
+    memset(arr, 0, sizeof(struct parray_value));
+    arr->size = size;
+}
+PADEF void parrayValueDeinit (struct parray_value* arr) {
+    parrayRealloc(arr->alloc, arr->data, arr->size*arr->capacity, 0);
+    parrayValueInitEx(arr, arr->size, arr->alloc);
+}
+PADEF void parrayValueInitEx (struct parray_value* arr, size_t size, const struct parray_allocator* alloc) {
+    parrayValueInit(arr, size);
+    arr->alloc = alloc;
+}
+PADEF struct parray_value* parrayValueNewEx (size_t size, const struct parray_allocator* alloc) {
+    struct parray_value* arr = parrayRealloc(alloc, NULL, 0, sizeof(struct parray_value));
+    if (arr) parrayValueInitEx(arr, size, alloc);
+    return arr;
+}
+PADEF struct parray_value* parrayValueNew (size_t size) {
+    return parrayValueNewEx(size, NULL);
+}
+PADEF PARRAY_INT parrayValueSet (struct parray_value* arr, PARRAY_INT ind, const void* ele) {
+    if ((ind < 0)||(ind >= arr->length)) return -1;
+    //the element may come from the value parray itself
+    memmove(parrayValueAt(arr, ind), ele, arr->size);
+    return ind;
+}
+PADEF void* parrayValueGetFirst (const struct parray_value* arr) {
+    return parrayValueGet(arr, 0);
+}
+PADEF void* parrayValueGetLast (const struct parray_value* arr) {
+    return parrayValueGet(arr, arr->length-1);
+}
+PADEF void* parrayValueData (struct parray_value* arr) {
+    return arr->data ? parrayValueAt(arr, 0) : NULL;
+}
+PADEF void parrayValueClear (struct parray_value* arr) {
+    arr->offset = arr->length = 0;
+}
+PADEF void parrayValueFree (struct parray_value* arr) {
+    parrayValueDeinit(arr);
+    parrayRealloc(arr->alloc, arr, sizeof(struct parray_value), 0);
+}
+PADEF PARRAY_INT parrayValuePush (struct parray_value* arr, const void* ele) {
+    if (parrayValueGrow(arr, 1)) return -1;
+    memcpy(parrayValueAt(arr, arr->length), ele, arr->size);
+    return arr->length++;
+}
+PADEF int parrayValuePop (struct parray_value* arr, void* out) {
+    if (!arr->length) return -1;
+    arr->length--; //reduce length
+    if (out) memcpy(out, parrayValueAt(arr, arr->length), arr->size);
+    return 0;
+}
+PADEF int parrayValueDequeue (struct parray_value* arr, void* out) {
+    if (!arr->length) return -1;
+    if (out) memcpy(out, parrayValueAt(arr, 0), arr->size);
+    arr->offset++;
+    if (!--arr->length) arr->offset = 0;
+    return 0;
+}
+PADEF PARRAY_INT parrayValueInsert (struct parray_value* arr, PARRAY_INT ind, const void* ele) {
+    if ((ind < 0)||(ind >= arr->length)||(parrayValueGrow(arr, 1))) return -1;
+    memmove(parrayValueAt(arr, ind+1), parrayValueAt(arr, ind), arr->size*(arr->length-ind));
+    memcpy(parrayValueAt(arr, ind), ele, arr->size); arr->length++;
+    return ind;
+}
+PADEF int parrayValueRemove (struct parray_value* arr, PARRAY_INT ind, void* out) {
+    if ((ind < 0)||(ind >= arr->length)) return -1;
+    if (out) memcpy(out, parrayValueAt(arr, ind), arr->size);
+    arr->length--;
+    memmove(parrayValueAt(arr, ind), parrayValueAt(arr, ind+1), arr->size*(arr->length-ind));
+    return 0;
+}
+PADEF int parrayValueDitch (struct parray_value* arr, PARRAY_INT ind, void* out) {
+    if ((ind < 0)||(ind >= arr->length)) return -1;
+    if (out) memcpy(out, parrayValueAt(arr, ind), arr->size);
+    if (ind < --arr->length) memcpy(parrayValueAt(arr, ind), parrayValueAt(arr, arr->length), arr->size);
+    return 0;
+}
+PADEF void parrayValueSortStandard (struct parray_value* arr, int(*comp)(const void*, const void*)) {
+    if (arr->length > 1) qsort(parrayValueAt(arr, 0), arr->length, arr->size, comp);
+}
+PADEF PARRAY_INT parrayValueFindIndex (const struct parray_value* arr, int(*comp)(const void*, const void*), const void* key) {
+    if (!arr->length) return -1; //nothing to search
+    char* res = bsearch(key, parrayValueAt(arr, 0), arr->length, arr->size, comp);
+    return res ? (PARRAY_INT)((size_t)(res-parrayValueAt(arr, 0))/arr->size) : -1;
+}
+PADEF void* parrayValueFindElement (const struct parray_value* arr, int(*comp)(const void*, const void*), const void* key) {
+    PARRAY_INT ind = parrayValueFindIndex(arr, comp, key);
+    return (ind < 0) ? NULL : parrayValueAt(arr, ind);
+}
+PADEF PARRAY_INT parrayValueLowerBound (const struct parray_value* arr, int(*comp)(const void*, const void*), const void* key) {
+    PARRAY_INT lo = 0, hi = arr->length;
+    while (lo < hi) {
+        PARRAY_INT mid = lo+(hi-lo)/2;
+        if (comp(key, parrayValueAt(arr, mid)) > 0) lo = mid+1;
+        else hi = mid;
+    }
+    return lo;
+}
+PADEF PARRAY_INT parrayValueCapacity (struct parray_value* arr, PARRAY_INT cap) {
+    if (cap < arr->length) cap = arr->length;
+    if (arr->offset) {
+        memmove(arr->data, parrayValueAt(arr, 0), arr->size*arr->length);
+        arr->offset = 0;
+    }
+    //adjust available capacity by reallocation
+    if ((cap != arr->capacity)&&(parrayValueResize(arr, cap))) return -1;
+    return arr->capacity;
+}
+
+//threading functions
+#ifdef PARRAY_THREADS
+struct parray_threadjob {
+    pthread_mutex_t lock;
+    void (*task)(void*, int);
+    void* ctx;
+    int next, num;
+};
+static void* parrayThreadMain (void* arg) {
+    //keeps claiming the next unclaimed task until none are left
+    struct parray_threadjob* job = arg;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int ind = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (ind >= job->num) return NULL;
+        job->task(job->ctx, ind);
+    }
+}
+PADEF void parrayRunThreads (const struct parray_executor* exec, void(*task)(void*, int), void* ctx, int num) {
+    struct parray_threadjob job = {PTHREAD_MUTEX_INITIALIZER, task, ctx, 0, num};
+    pthread_t threads[64]; int count = 0;
+    //the calling thread counts as one of the threads, tasks are simply run on fewer threads if creation fails
+    while ((count < exec->threads-1)&&(count < num-1)&&(count < 64)&&(!pthread_create(&threads[count], NULL, parrayThreadMain, &job)))
+        count++;
+    parrayThreadMain(&job);
+    while (count) pthread_join(threads[--count], NULL);
+}
+#endif
+
+//memory mapping functions
+#ifdef PARRAY_MMAP
+#define PARRAY_MMAP_HEADER 64 //room for the struct below at the start of each mapping, keeps elements cache line aligned
+#define PARRAY_HUGE_PAGE ((size_t)2 << 20)
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+    #define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_ANONYMOUS
+    #error "PARRAY_MMAP requires MAP_ANONYMOUS, which may need e.g. _DEFAULT_SOURCE defined before any system header"
+#endif
+#ifndef MAP_NORESERVE
+    #define MAP_NORESERVE 0
+#endif
+struct parray_mapping {
+    size_t reserved; //bytes of address space in the mapping
+    size_t committed; //bytes from the start of the mapping that are accessible
+    int flags; //PARRAY_MMAP_* flags the mapping was created with
+};
+static size_t parrayMapRound (size_t size, size_t align) {
+    return (size+align-1)/align*align;
+}
+static size_t parrayMapPage () {
+    long page = sysconf(_SC_PAGESIZE);
+    return (page > 0) ? (size_t)page : 4096;
+}
+static int parrayMapAccess (char* ptr, size_t size, int flags) {
+    //makes given reserved range accessible, returns 0 on success
+    #ifdef MAP_HUGETLB
+    if (flags & PARRAY_MMAP_HUGETLB) {
+        //explicit huge pages are taken from the pool right away, so running out falls back here instead of faulting later
+        if (mmap(ptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED|MAP_HUGETLB, -1, 0) != MAP_FAILED) return 0;
+        //a failed fixed mapping may have unmapped the range already, so it is mapped again instead of just protected
+        return mmap(ptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED, -1, 0) == MAP_FAILED;
+    }
+    #else
+    (void)flags;
+    #endif
+    return mprotect(ptr, size, PROT_READ|PROT_WRITE);
+}
+static int parrayMapCommit (struct parray_mapping* map, size_t size) {
+    //makes the first given number of bytes of given mapping accessible and gives back the pages after them, returns 0 on success
+    size = parrayMapRound(size, (map->flags & PARRAY_MMAP_HUGETLB) ? PARRAY_HUGE_PAGE : parrayMapPage());
+    if (size > map->committed) {
+        if (parrayMapAccess((char*)map+map->committed, size-map->committed, map->flags)) return -1;
+    } else if (size < map->committed) {
+        //mapping fresh inaccessible pages over the tail releases the old ones, failure to do so is harmless
+        mmap((char*)map+size, map->committed-size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE|MAP_FIXED, -1, 0);
+    }
+    map->committed = size;
+    return 0;
+}
+static struct parray_mapping* parrayMapReserve (const struct parray_mmap* cfg, size_t size) {
+    //reserves a mapping of at least given size and the configured reservation, committing the given size of it
+    size_t page = parrayMapPage(), align = (cfg->flags & (PARRAY_MMAP_HUGE|PARRAY_MMAP_HUGETLB)) ? PARRAY_HUGE_PAGE : page;
+    size_t reserve = parrayMapRound((size > cfg->reserve) ? size : cfg->reserve, align);
+    //over-reserve by one alignment unit, then trim both ends so the mapping starts on a huge page boundary
+    size_t extra = (align > page) ? align : 0;
+    char* base = mmap(NULL, reserve+extra, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+    char* start = (char*)parrayMapRound((size_t)(uintptr_t)base, align);
+    if (extra) {
+        if (start > base) munmap(base, start-base);
+        if (base+extra > start) munmap(start+reserve, base+extra-start);
+    }
+    #ifdef MADV_HUGEPAGE
+    if (cfg->flags & PARRAY_MMAP_HUGE) madvise(start, reserve, MADV_HUGEPAGE);
+    #endif
+    //the header lives in the mapping itself, so its page is committed before filling it in
+    size_t first = (cfg->flags & PARRAY_MMAP_HUGETLB) ? PARRAY_HUGE_PAGE : page;
+    struct parray_mapping* map = (struct parray_mapping*)start;
+    if (parrayMapAccess(start, first, cfg->flags)) {
+        munmap(start, reserve);
+        return NULL;
+    }
+    map->reserved = reserve;
+    map->committed = first;
+    map->flags = cfg->flags;
+    if (parrayMapCommit(map, size)) {
+        munmap(start, reserve);
+        return NULL;
+    }
+    return map;
+}
+PADEF void* parrayMmapAlloc (void* user, void* ptr, size_t old, size_t size) {
+    const struct parray_mmap* cfg = user;
+    //whether a block is mapped follows from its size alone, so no bookkeeping is needed for heap blocks
+    int mapped = (ptr)&&(old >= cfg->threshold);
+    struct parray_mapping* map = mapped ? (struct parray_mapping*)((char*)ptr-PARRAY_MMAP_HEADER) : NULL;
+    if ((!mapped)&&(size < cfg->threshold)) return parrayRealloc(NULL, ptr, old, size);
+    if (!size) {
+        if (map) munmap(map, map->reserved);
+        return NULL;
+    }
+    if ((mapped)&&(size >= cfg->threshold)&&(size <= map->reserved-PARRAY_MMAP_HEADER)) {
+        //grow or shrink in place
+        return parrayMapCommit(map, PARRAY_MMAP_HEADER+size) ? NULL : ptr;
+    }
+    //crossing the threshold or outgrowing the reservation moves the block, reserving at least twice as much as before
+    void* nptr;
+    if (size >= cfg->threshold) {
+        size_t want = PARRAY_MMAP_HEADER+size;
+        if ((mapped)&&(want < map->reserved*2)) want = map->reserved*2; //can't overflow, reservations are far below SIZE_MAX
+        struct parray_mapping* nmap = parrayMapReserve(cfg, want);
+        if ((!nmap)||(parrayMapCommit(nmap, PARRAY_MMAP_HEADER+size))) {
+            if (nmap) munmap(nmap, nmap->reserved);
+            return NULL;
+        }
+        nptr = (char*)nmap+PARRAY_MMAP_HEADER;
+    } else if (!(nptr = parrayRealloc(NULL, NULL, 0, size))) return NULL;
+    if (ptr) {
+        memcpy(nptr, ptr, (old < size) ? old : size);
+        if (mapped) munmap(map, map->reserved);
+        else parrayRealloc(NULL, ptr, old, 0);
+    }
+    return nptr;
+}
+#endif
+
+//concurrent queue functions
+#ifdef PARRAY_QUEUE
+#define PARRAY_CACHE_LINE 64
+#define PARRAY_CLOSED ((size_t)1 << (sizeof(size_t)*8-1))
+struct parray_qcell {
+    atomic_size_t seq; //position this cell is ready to be pushed at, or plus one to be dequeued at
+    void* ele;
+};
+struct parray_qring {
+    //head and tail are padded onto cache lines of their own, so producers and consumers don't invalidate each other's
+    atomic_size_t tail; //next position to push at, PARRAY_CLOSED is set once a growable queue moved past this ring
+    char pad0[PARRAY_CACHE_LINE-sizeof(atomic_size_t)];
+    atomic_size_t head; //next position to dequeue at
+    char pad1[PARRAY_CACHE_LINE-sizeof(atomic_size_t)];
+    _Atomic(struct parray_qring*) next; //larger ring that succeeded this one
+    size_t mask; //capacity minus one, capacity is a power of two
+    struct parray_qcell cells[];
+};
+struct parray_queue {
+    const struct parray_allocator* alloc;
+    struct parray_qring* first; //rings are only freed along with the queue, since other threads may still be reading them
+    int flags;
+    char pad0[PARRAY_CACHE_LINE];
+    _Atomic(struct parray_qring*) tail; //ring producers push to
+    char pad1[PARRAY_CACHE_LINE-sizeof(struct parray_qring*)];
+    _Atomic(struct parray_qring*) head; //ring consumers dequeue from
+    char pad2[PARRAY_CACHE_LINE-sizeof(struct parray_qring*)];
+};
+static size_t parrayQringSize (size_t cap) {
+    return sizeof(struct parray_qring)+sizeof(struct parray_qcell)*cap;
+}
+static struct parray_qring* parrayQringNew (const struct parray_allocator* alloc, size_t cap) {
+    //capacities past this would overflow the size of the ring
+    if (cap > (SIZE_MAX-sizeof(struct parray_qring))/sizeof(struct parray_qcell)) return NULL;
+    struct parray_qring* ring = parrayRealloc(alloc, NULL, 0, parrayQringSize(cap));
+    if (!ring) return NULL;
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->next, NULL);
+    ring->mask = cap-1;
+    for (size_t i = 0; i < cap; i++) atomic_init(&ring->cells[i].seq, i);
+    return ring;
+}
+static int parrayQringPush (struct parray_qring* ring, void* ele, int spsc) {
+    //bounded queue by dmitry vyukov, returns 0 on success or -1 if full or closed
+    size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    for (;;) {
+        if (pos & PARRAY_CLOSED) return -1;
+        struct parray_qcell* cell = &ring->cells[pos & ring->mask];
+        ptrdiff_t dif = (ptrdiff_t)(atomic_load_explicit(&cell->seq, memory_order_acquire)-pos);
+        if (dif < 0) return -1; //cell still holds the element pushed one lap ago
+        if ((!dif)&&(spsc)) {
+            //a single producer owns the tail, so no compare-and-swap is needed
+            atomic_store_explicit(&ring->tail, pos+1, memory_order_relaxed);
+        } else if ((dif)||(!atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos+1, memory_order_relaxed, memory_order_relaxed))) {
+            //another producer claimed this position first, pos is reloaded by the failed exchange
+            if (dif) pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            continue;
+        }
+        cell->ele = ele;
+        atomic_store_explicit(&cell->seq, pos+1, memory_order_release);
+        return 0;
+    }
+}
+static int parrayQringDequeue (struct parray_qring* ring, void** ele, int spsc) {
+    //returns 0 on success or -1 if empty
+    size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    for (;;) {
+        struct parray_qcell* cell = &ring->cells[pos & ring->mask];
+        ptrdiff_t dif = (ptrdiff_t)(atomic_load_explicit(&cell->seq, memory_order_acquire)-(pos+1));
+        if (dif < 0) return -1; //cell hasn't been pushed to yet
+        if ((!dif)&&(spsc)) {
+            atomic_store_explicit(&ring->head, pos+1, memory_order_relaxed);
+        } else if ((dif)||(!atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos+1, memory_order_relaxed, memory_order_relaxed))) {
+            if (dif) pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+            continue;
+        }
+        *ele = cell->ele;
+        //mark the cell ready to be pushed to on the next lap
+        atomic_store_explicit(&cell->seq, pos+ring->mask+1, memory_order_release);
+        return 0;
+    }
+}
+PADEF struct parray_queue* parrayQueueNewEx (PARRAY_INT cap, int flags, const struct parray_allocator* alloc) {
+    size_t size = 2;
+    while (size < (size_t)((cap > 0) ? cap : 0)) {
+        //rounding up must not leave the range of PARRAY_INT
+        if (size > (size_t)PARRAY_INT_MAX/2) return NULL;
+        size *= 2;
+    }
+    struct parray_queue* queue = parrayRealloc(alloc, NULL, 0, sizeof(struct parray_queue));
+    if (!queue) return NULL;
+    if (!(queue->first = parrayQringNew(alloc, size))) {
+        parrayRealloc(alloc, queue, sizeof(struct parray_queue), 0);
+        return NULL;
+    }
+    queue->alloc = alloc;
+    queue->flags = flags;
+    atomic_init(&queue->tail, queue->first);
+    atomic_init(&queue->head, queue->first);
+    return queue;
+}
+PADEF struct parray_queue* parrayQueueNew (PARRAY_INT cap, int flags) {
+    return parrayQueueNewEx(cap, flags, NULL);
+}
+PADEF int parrayQueuePush (struct parray_queue* queue, void* ele) {
+    int spsc = queue->flags & PARRAY_QUEUE_SPSC;
+    struct parray_qring* ring = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    while (parrayQringPush(ring, ele, spsc)) {
+        if (!(queue->flags & PARRAY_QUEUE_GROW)) return -1;
+        //close the full ring so no element can be pushed to it after ones pushed to its successor, keeping them in order
+        if (spsc) atomic_store_explicit(&ring->tail, atomic_load_explicit(&ring->tail, memory_order_relaxed) | PARRAY_CLOSED, memory_order_release);
+        else atomic_fetch_or_explicit(&ring->tail, PARRAY_CLOSED, memory_order_release);
+        struct parray_qring* next = atomic_load_explicit(&ring->next, memory_order_acquire);
+        if (!next) {
+            //the first producer to link a successor wins, any others throw theirs away
+            if (ring->mask+1 > (size_t)PARRAY_INT_MAX/2) return -1; //doubling would leave the range of PARRAY_INT
+            size_t cap = (ring->mask+1)*2;
+            struct parray_qring* grown = parrayQringNew(queue->alloc, cap);
+            if (!grown) return -1;
+            if (atomic_compare_exchange_strong_explicit(&ring->next, &next, grown, memory_order_acq_rel, memory_order_acquire)) next = grown;
+            else parrayRealloc(queue->alloc, grown, parrayQringSize(cap), 0);
+        }
+        //help move the tail along, it doesn't matter which producer succeeds
+        atomic_compare_exchange_strong_explicit(&queue->tail, &ring, next, memory_order_acq_rel, memory_order_acquire);
+        ring = next;
+    }
+    return 0;
+}
+PADEF void* parrayQueueDequeue (struct parray_queue* queue) {
+    int spsc = queue->flags & PARRAY_QUEUE_SPSC;
+    struct parray_qring* ring = atomic_load_explicit(&queue->head, memory_order_acquire);
+    void* ele;
+    while (parrayQringDequeue(ring, &ele, spsc)) {
+        //an empty ring is only done with once it is closed and every position claimed before closing has been dequeued
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if ((!(tail & PARRAY_CLOSED))||(atomic_load_explicit(&ring->head, memory_order_relaxed) != (tail & ~PARRAY_CLOSED))) return NULL;
+        struct parray_qring* next = atomic_load_explicit(&ring->next, memory_order_acquire);
+        if (!next) return NULL; //successor not linked yet, so nothing has been pushed to it either
+        atomic_compare_exchange_strong_explicit(&queue->head, &ring, next, memory_order_acq_rel, memory_order_acquire);
+        ring = next;
+    }
+    return ele;
+}
+PADEF PARRAY_INT parrayQueueLength (struct parray_queue* queue) {
+    size_t len = 0;
+    for (struct parray_qring* ring = atomic_load_explicit(&queue->head, memory_order_acquire); ring; ring = atomic_load_explicit(&ring->next, memory_order_acquire)) {
+        //the head is read first, so it can't have moved past a tail read afterwards
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire) & ~PARRAY_CLOSED;
+        if (tail > head) len += tail-head;
+    }
+    return (len > (size_t)PARRAY_INT_MAX) ? PARRAY_INT_MAX : (PARRAY_INT)len;
+}
+PADEF void parrayQueueFree (struct parray_queue* queue) {
+    for (struct parray_qring* ring = queue->first, *next; ring; ring = next) {
+        next = atomic_load_explicit(&ring->next, memory_order_relaxed);
+        parrayRealloc(queue->alloc, ring, parrayQringSize(ring->mask+1), 0);
+    }
+    parrayRealloc(queue->alloc, queue, sizeof(struct parray_queue), 0);
+}
+#endif
     
 #endif //PARRAY_IMPLEMENTATION
\ No newline at end of file